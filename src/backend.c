@@ -0,0 +1,677 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "backend.h"
+#include "stats.h"
+#include "trace.h"
+
+#define XFCONF_NAME "org.xfce.Xfconf"
+#define XFCONF_PATH "/org/xfce/Xfconf"
+#define XFCONF_CHANNEL "xsettings"
+#define CALL_TIMEOUT 5000
+
+typedef struct
+{
+    const gchar *sName;
+    const gchar *sContrastGtk;
+    const gchar *sContrastIcon;
+    gboolean (*pLoad) (Backend *pBackend);
+    void (*pSetContrast) (Backend *pBackend, gboolean bActive);
+    gboolean (*pBatchContrast) (Backend *pBackend, gboolean bActive, BackendBatchFunc pFunc, gpointer pUserData);
+} BackendClass;
+
+struct _Backend
+{
+    const BackendClass *pClass;
+    GDBusConnection *pConnection;
+    GCancellable *pCancellable;
+    GSettings *pSettings;
+    guint nSubscription;
+    gboolean bAvailable;
+    gboolean bKnown;
+    gboolean bContrast;
+    gchar *sThemeGtk;
+    gchar *sThemeIcon;
+    gchar *sCurrentGtk;
+    gchar *sCurrentIcon;
+    gchar *sWrittenGtk;
+    gchar *sWrittenIcon;
+    gint nWritten;
+    guint nIdle;
+    guint nPending;
+    gboolean bFailed;
+    gint64 nStart;
+    BackendFunc pChanged;
+    BackendFunc pApplied;
+    gpointer pUserData;
+};
+
+static BackendType m_eType = BACKEND_TYPES;
+
+static gboolean onApplied (gpointer pData)
+{
+    TRACE_ENTER ("onContrastApplied", "contrast", -1);
+
+    Backend *pBackend = pData;
+    pBackend->nIdle = 0;
+    pBackend->pApplied (pBackend, !pBackend->bFailed, pBackend->pUserData);
+    TRACE_LEAVE ("onContrastApplied", "contrast", !pBackend->bFailed);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void completeLater (Backend *pBackend, gboolean bSuccess)
+{
+    // Let already queued toggles coalesce before the write is considered done
+    pBackend->bFailed = !bSuccess;
+    pBackend->nIdle = g_idle_add_full (G_PRIORITY_LOW, onApplied, pBackend, NULL);
+}
+
+static void loadThemes (Backend *pBackend, gchar *sThemeGtk, gchar *sThemeIcon)
+{
+    g_free (pBackend->sCurrentGtk);
+    g_free (pBackend->sCurrentIcon);
+    pBackend->sCurrentGtk = sThemeGtk;
+    pBackend->sCurrentIcon = sThemeIcon;
+    pBackend->bContrast = g_strcmp0 (sThemeGtk, pBackend->pClass->sContrastGtk) == 0 && g_strcmp0 (sThemeIcon, pBackend->pClass->sContrastIcon) == 0;
+    pBackend->bKnown = TRUE;
+
+    // Keep the themes from the snapshot if high contrast is still on, they are the ones to restore
+    if (!pBackend->bContrast || !pBackend->sThemeGtk || !pBackend->sThemeIcon)
+    {
+        g_free (pBackend->sThemeGtk);
+        g_free (pBackend->sThemeIcon);
+        pBackend->sThemeGtk = g_strdup (sThemeGtk);
+        pBackend->sThemeIcon = g_strdup (sThemeIcon);
+    }
+}
+
+static gboolean prepareThemes (Backend *pBackend, gboolean bActive, const gchar **pThemeGtk, const gchar **pThemeIcon)
+{
+    if (bActive)
+    {
+        g_free (pBackend->sThemeGtk);
+        g_free (pBackend->sThemeIcon);
+        pBackend->sThemeGtk = g_strdup (pBackend->sCurrentGtk);
+        pBackend->sThemeIcon = g_strdup (pBackend->sCurrentIcon);
+        *pThemeGtk = pBackend->pClass->sContrastGtk;
+        *pThemeIcon = pBackend->pClass->sContrastIcon;
+    }
+    else
+    {
+        *pThemeGtk = pBackend->sThemeGtk;
+        *pThemeIcon = pBackend->sThemeIcon;
+    }
+
+    // Remember what we wrote, so the echo can be told apart from changes made by others
+    g_free (pBackend->sWrittenGtk);
+    g_free (pBackend->sWrittenIcon);
+    pBackend->sWrittenGtk = g_strdup (*pThemeGtk);
+    pBackend->sWrittenIcon = g_strdup (*pThemeIcon);
+
+    return *pThemeGtk && *pThemeIcon;
+}
+
+static gboolean updateTheme (gchar *sValue, gchar **pCurrent, gchar **pWritten, gchar **pTheme)
+{
+    g_free (*pCurrent);
+    *pCurrent = sValue;
+
+    if (g_strcmp0 (sValue, *pWritten) == 0)
+    {
+        stats_count (STATS_ECHOES_SUPPRESSED);
+
+        return FALSE;
+    }
+
+    // Someone else changed the theme, forget about our own write
+    g_clear_pointer (pWritten, g_free);
+    g_free (*pTheme);
+    *pTheme = g_strdup (sValue);
+
+    return TRUE;
+}
+
+static void themesChanged (Backend *pBackend)
+{
+    pBackend->bContrast = g_strcmp0 (pBackend->sCurrentGtk, pBackend->pClass->sContrastGtk) == 0 && g_strcmp0 (pBackend->sCurrentIcon, pBackend->pClass->sContrastIcon) == 0;
+    pBackend->pChanged (pBackend, pBackend->bContrast, pBackend->pUserData);
+}
+
+static gboolean onMateSettings (GSettings *pSettings, const GQuark *pKeys, gint nKeys, gpointer pUserData)
+{
+    TRACE_ENTER ("onContrastSettings", "contrast", -1);
+
+    stats_count (STATS_SETTINGS_NOTIFICATIONS);
+
+    Backend *pBackend = pUserData;
+    gboolean bChanged = FALSE;
+
+    for (gint nKey = 0; nKey < nKeys; nKey++)
+    {
+        const gchar *sKey = g_quark_to_string (pKeys[nKey]);
+
+        if (g_str_equal (sKey, "gtk-theme"))
+        {
+            bChanged |= updateTheme (g_settings_get_string (pSettings, sKey), &pBackend->sCurrentGtk, &pBackend->sWrittenGtk, &pBackend->sThemeGtk);
+        }
+        else if (g_str_equal (sKey, "icon-theme"))
+        {
+            bChanged |= updateTheme (g_settings_get_string (pSettings, sKey), &pBackend->sCurrentIcon, &pBackend->sWrittenIcon, &pBackend->sThemeIcon);
+        }
+    }
+
+    if (bChanged)
+    {
+        themesChanged (pBackend);
+    }
+
+    TRACE_LEAVE ("onContrastSettings", "contrast", pBackend->bContrast);
+
+    return FALSE;
+}
+
+static gboolean mateLoad (Backend *pBackend)
+{
+    pBackend->pSettings = backend_new_settings ("org.mate.interface", "gtk-theme");
+
+    if (!pBackend->pSettings)
+    {
+        return FALSE;
+    }
+
+    g_settings_delay (pBackend->pSettings);
+    loadThemes (pBackend, g_settings_get_string (pBackend->pSettings, "gtk-theme"), g_settings_get_string (pBackend->pSettings, "icon-theme"));
+    g_signal_connect (pBackend->pSettings, "change-event", G_CALLBACK (onMateSettings), pBackend);
+
+    return TRUE;
+}
+
+static void mateSetContrast (Backend *pBackend, gboolean bActive)
+{
+    const gchar *sThemeGtk = NULL;
+    const gchar *sThemeIcon = NULL;
+
+    if (!prepareThemes (pBackend, bActive, &sThemeGtk, &sThemeIcon))
+    {
+        completeLater (pBackend, FALSE);
+
+        return;
+    }
+
+    // The settings object is in delay-apply mode: both keys are committed in one transaction
+    gint64 nStart = g_get_monotonic_time ();
+    g_settings_set_string (pBackend->pSettings, "gtk-theme", sThemeGtk);
+    g_settings_set_string (pBackend->pSettings, "icon-theme", sThemeIcon);
+    g_settings_apply (pBackend->pSettings);
+    stats_count (STATS_BACKEND_CALLS);
+    stats_latency (STATS_LATENCY_SETTINGS, g_get_monotonic_time () - nStart);
+    completeLater (pBackend, TRUE);
+}
+
+static gboolean mateBatchContrast (Backend *pBackend, gboolean bActive, BackendBatchFunc pFunc, gpointer pUserData)
+{
+    const gchar *sThemeGtk = NULL;
+    const gchar *sThemeIcon = NULL;
+
+    if (!prepareThemes (pBackend, bActive, &sThemeGtk, &sThemeIcon))
+    {
+        return FALSE;
+    }
+
+    pFunc ("org.mate.interface", "gtk-theme", g_variant_new_string (sThemeGtk), pUserData);
+    pFunc ("org.mate.interface", "icon-theme", g_variant_new_string (sThemeIcon), pUserData);
+
+    return TRUE;
+}
+
+static void onGnomeSettings (GSettings *pSettings, const gchar *sKey, gpointer pUserData)
+{
+    TRACE_ENTER ("onContrastSettings", "contrast", -1);
+
+    stats_count (STATS_SETTINGS_NOTIFICATIONS);
+
+    Backend *pBackend = pUserData;
+    gboolean bActive = g_settings_get_boolean (pSettings, "high-contrast");
+    gboolean bEcho = (pBackend->nWritten == bActive);
+    pBackend->nWritten = -1;
+    pBackend->bContrast = bActive;
+
+    if (bEcho)
+    {
+        stats_count (STATS_ECHOES_SUPPRESSED);
+    }
+    else
+    {
+        pBackend->pChanged (pBackend, bActive, pBackend->pUserData);
+    }
+
+    TRACE_LEAVE ("onContrastSettings", "contrast", bActive);
+}
+
+static gboolean gnomeLoad (Backend *pBackend)
+{
+    pBackend->pSettings = backend_new_settings ("org.gnome.desktop.a11y.interface", "high-contrast");
+
+    if (!pBackend->pSettings)
+    {
+        return FALSE;
+    }
+
+    pBackend->nWritten = -1;
+    pBackend->bContrast = g_settings_get_boolean (pBackend->pSettings, "high-contrast");
+    pBackend->bKnown = TRUE;
+    g_signal_connect (pBackend->pSettings, "changed::high-contrast", G_CALLBACK (onGnomeSettings), pBackend);
+
+    return TRUE;
+}
+
+static void gnomeSetContrast (Backend *pBackend, gboolean bActive)
+{
+    pBackend->nWritten = bActive;
+
+    gint64 nStart = g_get_monotonic_time ();
+    g_settings_set_boolean (pBackend->pSettings, "high-contrast", bActive);
+    stats_count (STATS_BACKEND_CALLS);
+    stats_latency (STATS_LATENCY_SETTINGS, g_get_monotonic_time () - nStart);
+    completeLater (pBackend, TRUE);
+}
+
+static gboolean gnomeBatchContrast (Backend *pBackend, gboolean bActive, BackendBatchFunc pFunc, gpointer pUserData)
+{
+    pBackend->nWritten = bActive;
+    pFunc ("org.gnome.desktop.a11y.interface", "high-contrast", g_variant_new_boolean (bActive), pUserData);
+
+    return TRUE;
+}
+
+static void onXfconfChanged (GDBusConnection *pConnection, const gchar *sSender, const gchar *sPath, const gchar *sInterface, const gchar *sSignal, GVariant *pParameters, gpointer pUserData)
+{
+    TRACE_ENTER ("onXfconfChanged", "contrast", -1);
+
+    stats_count (STATS_SETTINGS_NOTIFICATIONS);
+
+    Backend *pBackend = pUserData;
+
+    if (!g_variant_is_of_type (pParameters, G_VARIANT_TYPE ("(ssv)")))
+    {
+        TRACE_LEAVE ("onXfconfChanged", "contrast", -1);
+
+        return;
+    }
+
+    const gchar *sProperty = NULL;
+    GVariant *pValue = NULL;
+    gboolean bChanged = FALSE;
+    g_variant_get (pParameters, "(&s&sv)", NULL, &sProperty, &pValue);
+
+    if (g_variant_is_of_type (pValue, G_VARIANT_TYPE_STRING))
+    {
+        if (g_str_equal (sProperty, "/Net/ThemeName"))
+        {
+            bChanged = updateTheme (g_variant_dup_string (pValue, NULL), &pBackend->sCurrentGtk, &pBackend->sWrittenGtk, &pBackend->sThemeGtk);
+        }
+        else if (g_str_equal (sProperty, "/Net/IconThemeName"))
+        {
+            bChanged = updateTheme (g_variant_dup_string (pValue, NULL), &pBackend->sCurrentIcon, &pBackend->sWrittenIcon, &pBackend->sThemeIcon);
+        }
+    }
+
+    g_variant_unref (pValue);
+
+    if (bChanged)
+    {
+        themesChanged (pBackend);
+    }
+
+    TRACE_LEAVE ("onXfconfChanged", "contrast", pBackend->bContrast);
+}
+
+static void onXfconfProperties (GObject *pObject, GAsyncResult *pResult, gpointer pUserData)
+{
+    TRACE_ENTER ("onXfconfProperties", "contrast", -1);
+
+    GError *pError = NULL;
+    GVariant *pRet = g_dbus_connection_call_finish (G_DBUS_CONNECTION (pObject), pResult, &pError);
+
+    if (g_error_matches (pError, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+        // The backend is gone, do not touch it
+        g_error_free (pError);
+        TRACE_LEAVE ("onXfconfProperties", "contrast", -1);
+
+        return;
+    }
+
+    Backend *pBackend = pUserData;
+
+    if (pError)
+    {
+        g_warning ("Failed to get the Xfce settings: %s", pError->message);
+        g_error_free (pError);
+        pBackend->bAvailable = FALSE;
+    }
+    else
+    {
+        gchar *sThemeGtk = NULL;
+        gchar *sThemeIcon = NULL;
+        GVariant *pDict = g_variant_get_child_value (pRet, 0);
+        g_variant_lookup (pDict, "/Net/ThemeName", "s", &sThemeGtk);
+        g_variant_lookup (pDict, "/Net/IconThemeName", "s", &sThemeIcon);
+        loadThemes (pBackend, sThemeGtk, sThemeIcon);
+        g_variant_unref (pDict);
+        g_variant_unref (pRet);
+    }
+
+    pBackend->pChanged (pBackend, pBackend->bContrast, pBackend->pUserData);
+    TRACE_LEAVE ("onXfconfProperties", "contrast", pBackend->bContrast);
+}
+
+static gboolean xfceLoad (Backend *pBackend)
+{
+    if (!pBackend->pConnection)
+    {
+        return FALSE;
+    }
+
+    // The state is unknown until xfconfd answers
+    pBackend->nSubscription = g_dbus_connection_signal_subscribe (pBackend->pConnection, XFCONF_NAME, XFCONF_NAME, "PropertyChanged", XFCONF_PATH, XFCONF_CHANNEL, G_DBUS_SIGNAL_FLAGS_NONE, onXfconfChanged, pBackend, NULL);
+    stats_count (STATS_BACKEND_CALLS);
+    g_dbus_connection_call (pBackend->pConnection, XFCONF_NAME, XFCONF_PATH, XFCONF_NAME, "GetAllProperties", g_variant_new ("(ss)", XFCONF_CHANNEL, "/Net"), G_VARIANT_TYPE ("(a{sv})"), G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT, pBackend->pCancellable, onXfconfProperties, pBackend);
+
+    return TRUE;
+}
+
+static void onXfconfSet (GObject *pObject, GAsyncResult *pResult, gpointer pUserData)
+{
+    TRACE_ENTER ("onXfconfSet", "contrast", -1);
+
+    GError *pError = NULL;
+    GVariant *pRet = g_dbus_connection_call_finish (G_DBUS_CONNECTION (pObject), pResult, &pError);
+
+    if (pRet)
+    {
+        g_variant_unref (pRet);
+    }
+
+    if (g_error_matches (pError, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+        g_error_free (pError);
+        TRACE_LEAVE ("onXfconfSet", "contrast", -1);
+
+        return;
+    }
+
+    Backend *pBackend = pUserData;
+
+    if (pError)
+    {
+        g_warning ("Failed to change the Xfce settings: %s", pError->message);
+        g_error_free (pError);
+        pBackend->bFailed = TRUE;
+    }
+
+    // Both properties are written concurrently, the change is done with the last reply
+    if (--pBackend->nPending == 0)
+    {
+        stats_latency (STATS_LATENCY_SETTINGS, g_get_monotonic_time () - pBackend->nStart);
+        pBackend->pApplied (pBackend, !pBackend->bFailed, pBackend->pUserData);
+    }
+
+    TRACE_LEAVE ("onXfconfSet", "contrast", !pBackend->bFailed);
+}
+
+static void xfceSetContrast (Backend *pBackend, gboolean bActive)
+{
+    const gchar *lThemes[2] = {NULL, NULL};
+
+    if (!prepareThemes (pBackend, bActive, &lThemes[0], &lThemes[1]))
+    {
+        completeLater (pBackend, FALSE);
+
+        return;
+    }
+
+    const gchar *lProperties[2] = {"/Net/ThemeName", "/Net/IconThemeName"};
+    pBackend->bFailed = FALSE;
+    pBackend->nPending = 2;
+    pBackend->nStart = g_get_monotonic_time ();
+
+    for (guint nProperty = 0; nProperty < 2; nProperty++)
+    {
+        stats_count (STATS_BACKEND_CALLS);
+        g_dbus_connection_call (pBackend->pConnection, XFCONF_NAME, XFCONF_PATH, XFCONF_NAME, "SetProperty", g_variant_new ("(ssv)", XFCONF_CHANNEL, lProperties[nProperty], g_variant_new_string (lThemes[nProperty])), NULL, G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT, pBackend->pCancellable, onXfconfSet, pBackend);
+    }
+}
+
+// The greeter toggles its own high contrast, Onboard and Orca go through the greeter bridge
+static const BackendClass m_lClasses[BACKEND_TYPES] =
+{
+    {"MATE", "ContrastHigh", "ContrastHigh", mateLoad, mateSetContrast, mateBatchContrast},
+    {"GNOME", NULL, NULL, gnomeLoad, gnomeSetContrast, gnomeBatchContrast},
+    {"Xfce", "HighContrast", "HighContrast", xfceLoad, xfceSetContrast, NULL},
+    {"greeter", NULL, NULL, NULL, NULL, NULL}
+};
+
+BackendType backend_detect ()
+{
+    if (m_eType != BACKEND_TYPES)
+    {
+        return m_eType;
+    }
+
+    // Forced from the environment, for the test harness and for debugging
+    const gchar *sBackend = g_getenv ("AYATANA_A11Y_BACKEND");
+
+    for (guint nType = 0; sBackend && nType < BACKEND_TYPES; nType++)
+    {
+        if (!g_ascii_strcasecmp (sBackend, m_lClasses[nType].sName))
+        {
+            m_eType = nType;
+            g_debug ("Using the %s backend from AYATANA_A11Y_BACKEND", m_lClasses[m_eType].sName);
+
+            return m_eType;
+        }
+    }
+
+    // MATE is what we always used, keep it for unknown desktops
+    m_eType = BACKEND_MATE;
+
+    if (g_str_equal (g_get_user_name (), "lightdm"))
+    {
+        m_eType = BACKEND_GREETER;
+    }
+    else
+    {
+        const gchar *sDesktops = g_getenv ("XDG_CURRENT_DESKTOP");
+        gchar **lDesktops = g_strsplit (sDesktops ? sDesktops : "", ":", -1);
+
+        for (guint nDesktop = 0; lDesktops[nDesktop]; nDesktop++)
+        {
+            if (!g_ascii_strcasecmp (lDesktops[nDesktop], "MATE"))
+            {
+                m_eType = BACKEND_MATE;
+
+                break;
+            }
+            else if (!g_ascii_strcasecmp (lDesktops[nDesktop], "XFCE"))
+            {
+                m_eType = BACKEND_XFCE;
+
+                break;
+            }
+            else if (!g_ascii_strcasecmp (lDesktops[nDesktop], "GNOME") || !g_ascii_strcasecmp (lDesktops[nDesktop], "Unity"))
+            {
+                m_eType = BACKEND_GNOME;
+
+                break;
+            }
+        }
+
+        g_strfreev (lDesktops);
+    }
+
+    g_debug ("Using the %s backend", m_lClasses[m_eType].sName);
+
+    return m_eType;
+}
+
+const gchar* backend_get_name (BackendType eType)
+{
+    return m_lClasses[eType].sName;
+}
+
+Backend* backend_new (BackendType eType, GDBusConnection *pConnection, const gchar *sThemeGtk, const gchar *sThemeIcon, BackendFunc pChanged, BackendFunc pApplied, gpointer pUserData)
+{
+    if (!m_lClasses[eType].pLoad)
+    {
+        return NULL;
+    }
+
+    Backend *pBackend = g_new0 (Backend, 1);
+    pBackend->pClass = &m_lClasses[eType];
+    pBackend->pConnection = pConnection;
+    pBackend->pCancellable = g_cancellable_new ();
+    pBackend->bAvailable = TRUE;
+    pBackend->sThemeGtk = g_strdup (sThemeGtk);
+    pBackend->sThemeIcon = g_strdup (sThemeIcon);
+    pBackend->pChanged = pChanged;
+    pBackend->pApplied = pApplied;
+    pBackend->pUserData = pUserData;
+
+    if (!pBackend->pClass->pLoad (pBackend))
+    {
+        backend_free (pBackend);
+
+        return NULL;
+    }
+
+    return pBackend;
+}
+
+void backend_free (Backend *pBackend)
+{
+    g_cancellable_cancel (pBackend->pCancellable);
+    g_object_unref (pBackend->pCancellable);
+
+    if (pBackend->nIdle)
+    {
+        g_source_remove (pBackend->nIdle);
+    }
+
+    if (pBackend->nSubscription)
+    {
+        g_dbus_connection_signal_unsubscribe (pBackend->pConnection, pBackend->nSubscription);
+    }
+
+    if (pBackend->pSettings)
+    {
+        g_signal_handlers_disconnect_by_data (pBackend->pSettings, pBackend);
+        g_object_unref (pBackend->pSettings);
+    }
+
+    g_free (pBackend->sThemeGtk);
+    g_free (pBackend->sThemeIcon);
+    g_free (pBackend->sCurrentGtk);
+    g_free (pBackend->sCurrentIcon);
+    g_free (pBackend->sWrittenGtk);
+    g_free (pBackend->sWrittenIcon);
+    g_free (pBackend);
+}
+
+gboolean backend_is_available (Backend *pBackend)
+{
+    return pBackend->bAvailable;
+}
+
+gboolean backend_get_contrast (Backend *pBackend, gboolean *pActive)
+{
+    if (!pBackend->bKnown)
+    {
+        return FALSE;
+    }
+
+    *pActive = pBackend->bContrast;
+
+    return TRUE;
+}
+
+void backend_set_contrast (Backend *pBackend, gboolean bActive)
+{
+    if (!pBackend->bAvailable || !pBackend->bKnown)
+    {
+        completeLater (pBackend, FALSE);
+
+        return;
+    }
+
+    pBackend->pClass->pSetContrast (pBackend, bActive);
+}
+
+gboolean backend_batch_contrast (Backend *pBackend, gboolean bActive, BackendBatchFunc pFunc, gpointer pUserData)
+{
+    // Only settings based backends can hand their keys to someone else's transaction
+    if (!pBackend->pClass->pBatchContrast || !pBackend->bAvailable || !pBackend->bKnown)
+    {
+        return FALSE;
+    }
+
+    return pBackend->pClass->pBatchContrast (pBackend, bActive, pFunc, pUserData);
+}
+
+const gchar* backend_get_theme_gtk (Backend *pBackend)
+{
+    return pBackend->sThemeGtk;
+}
+
+const gchar* backend_get_theme_icon (Backend *pBackend)
+{
+    return pBackend->sThemeIcon;
+}
+
+gboolean backend_has_key (const gchar *sSchema, const gchar *sKey)
+{
+    GSettingsSchemaSource *pSource = g_settings_schema_source_get_default ();
+
+    if (!pSource)
+    {
+        return FALSE;
+    }
+
+    GSettingsSchema *pSchema = g_settings_schema_source_lookup (pSource, sSchema, TRUE);
+
+    if (!pSchema)
+    {
+        return FALSE;
+    }
+
+    gboolean bKey = g_settings_schema_has_key (pSchema, sKey);
+    g_settings_schema_unref (pSchema);
+
+    return bKey;
+}
+
+GSettings* backend_new_settings (const gchar *sSchema, const gchar *sKey)
+{
+    // g_settings_new () aborts on a missing schema, desktops ship different ones
+    if (!backend_has_key (sSchema, sKey))
+    {
+        return NULL;
+    }
+
+    return g_settings_new (sSchema);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __INDICATOR_A11Y_BACKEND_H__
+#define __INDICATOR_A11Y_BACKEND_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    BACKEND_MATE,
+    BACKEND_GNOME,
+    BACKEND_XFCE,
+    BACKEND_GREETER,
+    BACKEND_TYPES
+} BackendType;
+
+typedef struct _Backend Backend;
+typedef void (*BackendFunc) (Backend *pBackend, gboolean bActive, gpointer pUserData);
+typedef void (*BackendBatchFunc) (const gchar *sSchema, const gchar *sKey, GVariant *pValue, gpointer pUserData);
+
+BackendType backend_detect ();
+const gchar* backend_get_name (BackendType eType);
+Backend* backend_new (BackendType eType, GDBusConnection *pConnection, const gchar *sThemeGtk, const gchar *sThemeIcon, BackendFunc pChanged, BackendFunc pApplied, gpointer pUserData);
+void backend_free (Backend *pBackend);
+gboolean backend_is_available (Backend *pBackend);
+gboolean backend_get_contrast (Backend *pBackend, gboolean *pActive);
+void backend_set_contrast (Backend *pBackend, gboolean bActive);
+gboolean backend_batch_contrast (Backend *pBackend, gboolean bActive, BackendBatchFunc pFunc, gpointer pUserData);
+const gchar* backend_get_theme_gtk (Backend *pBackend);
+const gchar* backend_get_theme_icon (Backend *pBackend);
+gboolean backend_has_key (const gchar *sSchema, const gchar *sKey);
+GSettings* backend_new_settings (const gchar *sSchema, const gchar *sKey);
+
+G_END_DECLS
+
+#endif
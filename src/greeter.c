@@ -0,0 +1,150 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "greeter.h"
+
+#define GREETER_NAME "org.ArcticaProject.ArcticaGreeter"
+#define GREETER_PATH "/org/ArcticaProject/ArcticaGreeter"
+
+struct _GreeterBridge
+{
+    GDBusConnection *pConnection;
+    GCancellable *pCancellable;
+    gint nTimeout;
+    GHashTable *pUnavailable;
+    guint nWatch;
+    GreeterBridgeAppearedFunc pAppeared;
+    gpointer pUserData;
+};
+
+typedef struct
+{
+    GreeterBridge *pBridge;
+    gchar *sMethod;
+    gint64 nStart;
+    GreeterBridgeFunc pFunc;
+    gpointer pUserData;
+} GreeterCall;
+
+static gboolean isFatal (GError *pError)
+{
+    // Errors that will not go away by retrying, a greeter that is not on the bus yet may still come
+    return g_error_matches (pError, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD) || g_error_matches (pError, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_INTERFACE) || g_error_matches (pError, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_OBJECT);
+}
+
+static void onCall (GObject *pObject, GAsyncResult *pResult, gpointer pUserData)
+{
+    GreeterCall *pCall = pUserData;
+    GError *pError = NULL;
+    GVariant *pRet = g_dbus_connection_call_finish (G_DBUS_CONNECTION (pObject), pResult, &pError);
+
+    if (pRet)
+    {
+        g_variant_unref (pRet);
+    }
+
+    if (g_error_matches (pError, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+        // The bridge is gone, do not touch it
+        g_error_free (pError);
+        g_free (pCall->sMethod);
+        g_free (pCall);
+
+        return;
+    }
+
+    gint64 nLatency = g_get_monotonic_time () - pCall->nStart;
+    gboolean bSuccess = (pError == NULL);
+
+    if (pError)
+    {
+        if (isFatal (pError))
+        {
+            g_warning ("%s is not available: %s", pCall->sMethod, pError->message);
+            g_hash_table_add (pCall->pBridge->pUnavailable, g_strdup (pCall->sMethod));
+        }
+        else
+        {
+            g_warning ("Failed to call %s: %s", pCall->sMethod, pError->message);
+        }
+
+        g_error_free (pError);
+    }
+
+    g_debug ("%s returned after %" G_GINT64_FORMAT " us", pCall->sMethod, nLatency);
+    pCall->pFunc (pCall->pBridge, pCall->sMethod, bSuccess, nLatency, pCall->pUserData);
+    g_free (pCall->sMethod);
+    g_free (pCall);
+}
+
+static void onAppeared (GDBusConnection *pConnection, const gchar *sName, const gchar *sOwner, gpointer pData)
+{
+    GreeterBridge *pBridge = pData;
+
+    g_debug ("%s appeared as %s", sName, sOwner);
+
+    // A new greeter instance gets a fresh chance
+    g_hash_table_remove_all (pBridge->pUnavailable);
+
+    if (pBridge->pAppeared)
+    {
+        pBridge->pAppeared (pBridge, pBridge->pUserData);
+    }
+}
+
+GreeterBridge* greeter_bridge_new (GDBusConnection *pConnection, gint nTimeout, GreeterBridgeAppearedFunc pAppeared, gpointer pUserData)
+{
+    GreeterBridge *pBridge = g_new0 (GreeterBridge, 1);
+    pBridge->pConnection = g_object_ref (pConnection);
+    pBridge->pCancellable = g_cancellable_new ();
+    pBridge->nTimeout = nTimeout;
+    pBridge->pUnavailable = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    pBridge->pAppeared = pAppeared;
+    pBridge->pUserData = pUserData;
+    pBridge->nWatch = g_bus_watch_name_on_connection (pConnection, GREETER_NAME, G_BUS_NAME_WATCHER_FLAGS_NONE, onAppeared, NULL, pBridge, NULL);
+
+    return pBridge;
+}
+
+void greeter_bridge_free (GreeterBridge *pBridge)
+{
+    g_bus_unwatch_name (pBridge->nWatch);
+    g_cancellable_cancel (pBridge->pCancellable);
+    g_clear_object (&pBridge->pCancellable);
+    g_clear_object (&pBridge->pConnection);
+    g_hash_table_destroy (pBridge->pUnavailable);
+    g_free (pBridge);
+}
+
+void greeter_bridge_toggle (GreeterBridge *pBridge, const gchar *sMethod, gboolean bActive, GreeterBridgeFunc pFunc, gpointer pUserData)
+{
+    // Calls are not serialised: requests for different features are in flight at the same time
+    GreeterCall *pCall = g_new0 (GreeterCall, 1);
+    pCall->pBridge = pBridge;
+    pCall->sMethod = g_strdup (sMethod);
+    pCall->nStart = g_get_monotonic_time ();
+    pCall->pFunc = pFunc;
+    pCall->pUserData = pUserData;
+
+    GVariant *pParam = g_variant_new ("(b)", bActive);
+    g_dbus_connection_call (pBridge->pConnection, GREETER_NAME, GREETER_PATH, GREETER_NAME, sMethod, pParam, NULL, G_DBUS_CALL_FLAGS_NONE, pBridge->nTimeout, pBridge->pCancellable, onCall, pCall);
+}
+
+gboolean greeter_bridge_is_available (GreeterBridge *pBridge, const gchar *sMethod)
+{
+    return !g_hash_table_contains (pBridge->pUnavailable, sMethod);
+}
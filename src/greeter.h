@@ -0,0 +1,35 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INDICATOR_A11Y_GREETER_H__
+#define __INDICATOR_A11Y_GREETER_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GreeterBridge GreeterBridge;
+typedef void (*GreeterBridgeFunc) (GreeterBridge *pBridge, const gchar *sMethod, gboolean bSuccess, gint64 nLatency, gpointer pUserData);
+typedef void (*GreeterBridgeAppearedFunc) (GreeterBridge *pBridge, gpointer pUserData);
+
+GreeterBridge* greeter_bridge_new (GDBusConnection *pConnection, gint nTimeout, GreeterBridgeAppearedFunc pAppeared, gpointer pUserData);
+void greeter_bridge_free (GreeterBridge *pBridge);
+void greeter_bridge_toggle (GreeterBridge *pBridge, const gchar *sMethod, gboolean bActive, GreeterBridgeFunc pFunc, gpointer pUserData);
+gboolean greeter_bridge_is_available (GreeterBridge *pBridge, const gchar *sMethod);
+
+G_END_DECLS
+
+#endif
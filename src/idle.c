@@ -0,0 +1,228 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "idle.h"
+
+struct _IdleMonitor
+{
+    gint nRef;
+    GDBusConnection *pConnection;
+    GMainContext *pContext;
+    gchar *sMenuPath;
+    guint nFilter;
+    guint nTimeout;
+    guint nTimer;
+    guint nPending;
+    GHashTable *pSubscribers;
+    IdleMonitorFunc pFunc;
+    gpointer pUserData;
+    gboolean bDisposed;
+};
+
+typedef struct
+{
+    IdleMonitor *pMonitor;
+    gchar *sSender;
+    gboolean bStart;
+} MenuEvent;
+
+typedef struct
+{
+    guint nWatch;
+    guint nCount;
+} Subscriber;
+
+static IdleMonitor* idleMonitorRef (IdleMonitor *pMonitor)
+{
+    g_atomic_int_inc (&pMonitor->nRef);
+
+    return pMonitor;
+}
+
+static void idleMonitorUnref (gpointer pData)
+{
+    IdleMonitor *pMonitor = pData;
+
+    if (g_atomic_int_dec_and_test (&pMonitor->nRef))
+    {
+        g_object_unref (pMonitor->pConnection);
+        g_main_context_unref (pMonitor->pContext);
+        g_free (pMonitor->sMenuPath);
+        g_free (pMonitor);
+    }
+}
+
+static void freeSubscriber (gpointer pData)
+{
+    Subscriber *pSubscriber = pData;
+    g_bus_unwatch_name (pSubscriber->nWatch);
+    g_free (pSubscriber);
+}
+
+static gboolean onTimeout (gpointer pData)
+{
+    IdleMonitor *pMonitor = pData;
+    pMonitor->nTimer = 0;
+
+    g_debug ("idle for %u s", pMonitor->nTimeout);
+    pMonitor->pFunc (pMonitor->pUserData);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void update (IdleMonitor *pMonitor)
+{
+    if (pMonitor->nTimer)
+    {
+        g_source_remove (pMonitor->nTimer);
+        pMonitor->nTimer = 0;
+    }
+
+    if (!pMonitor->nPending && !g_hash_table_size (pMonitor->pSubscribers))
+    {
+        pMonitor->nTimer = g_timeout_add_seconds (pMonitor->nTimeout, onTimeout, pMonitor);
+    }
+}
+
+static void onSubscriberVanished (GDBusConnection *pConnection, const gchar *sName, gpointer pData)
+{
+    IdleMonitor *pMonitor = pData;
+
+    // A menu client went away without unsubscribing
+    g_hash_table_remove (pMonitor->pSubscribers, sName);
+    update (pMonitor);
+}
+
+static gboolean onMenuEvent (gpointer pData)
+{
+    MenuEvent *pEvent = pData;
+    IdleMonitor *pMonitor = pEvent->pMonitor;
+
+    if (pMonitor->bDisposed)
+    {
+        return G_SOURCE_REMOVE;
+    }
+
+    Subscriber *pSubscriber = g_hash_table_lookup (pMonitor->pSubscribers, pEvent->sSender);
+
+    if (pEvent->bStart)
+    {
+        if (!pSubscriber)
+        {
+            pSubscriber = g_new0 (Subscriber, 1);
+            pSubscriber->nWatch = g_bus_watch_name_on_connection (pMonitor->pConnection, pEvent->sSender, G_BUS_NAME_WATCHER_FLAGS_NONE, NULL, onSubscriberVanished, pMonitor, NULL);
+            g_hash_table_insert (pMonitor->pSubscribers, g_strdup (pEvent->sSender), pSubscriber);
+        }
+
+        pSubscriber->nCount++;
+    }
+    else if (pSubscriber && !--pSubscriber->nCount)
+    {
+        g_hash_table_remove (pMonitor->pSubscribers, pEvent->sSender);
+    }
+
+    update (pMonitor);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void freeMenuEvent (gpointer pData)
+{
+    MenuEvent *pEvent = pData;
+    idleMonitorUnref (pEvent->pMonitor);
+    g_free (pEvent->sSender);
+    g_free (pEvent);
+}
+
+static GDBusMessage* onMessage (GDBusConnection *pConnection, GDBusMessage *pMessage, gboolean bIncoming, gpointer pData)
+{
+    // Runs in the GDBus worker thread: only pick out menu (un)subscriptions and hand them over
+    IdleMonitor *pMonitor = pData;
+
+    if (!bIncoming || g_dbus_message_get_message_type (pMessage) != G_DBUS_MESSAGE_TYPE_METHOD_CALL)
+    {
+        return pMessage;
+    }
+
+    if (g_strcmp0 (g_dbus_message_get_interface (pMessage), "org.gtk.Menus") != 0 || g_strcmp0 (g_dbus_message_get_path (pMessage), pMonitor->sMenuPath) != 0)
+    {
+        return pMessage;
+    }
+
+    const gchar *sMember = g_dbus_message_get_member (pMessage);
+    gboolean bStart = (g_strcmp0 (sMember, "Start") == 0);
+
+    if ((bStart || g_strcmp0 (sMember, "End") == 0) && g_dbus_message_get_sender (pMessage))
+    {
+        MenuEvent *pEvent = g_new0 (MenuEvent, 1);
+        pEvent->pMonitor = idleMonitorRef (pMonitor);
+        pEvent->sSender = g_strdup (g_dbus_message_get_sender (pMessage));
+        pEvent->bStart = bStart;
+        g_main_context_invoke_full (pMonitor->pContext, G_PRIORITY_DEFAULT, onMenuEvent, pEvent, freeMenuEvent);
+    }
+
+    return pMessage;
+}
+
+IdleMonitor* idle_monitor_new (GDBusConnection *pConnection, const gchar *sMenuPath, guint nTimeout, IdleMonitorFunc pFunc, gpointer pUserData)
+{
+    IdleMonitor *pMonitor = g_new0 (IdleMonitor, 1);
+    pMonitor->nRef = 1;
+    pMonitor->pConnection = g_object_ref (pConnection);
+    pMonitor->pContext = g_main_context_ref_thread_default ();
+    pMonitor->sMenuPath = g_strdup (sMenuPath);
+    pMonitor->nTimeout = nTimeout;
+    pMonitor->pSubscribers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, freeSubscriber);
+    pMonitor->pFunc = pFunc;
+    pMonitor->pUserData = pUserData;
+    pMonitor->nFilter = g_dbus_connection_add_filter (pConnection, onMessage, idleMonitorRef (pMonitor), idleMonitorUnref);
+    update (pMonitor);
+
+    return pMonitor;
+}
+
+void idle_monitor_free (IdleMonitor *pMonitor)
+{
+    pMonitor->bDisposed = TRUE;
+    g_dbus_connection_remove_filter (pMonitor->pConnection, pMonitor->nFilter);
+
+    if (pMonitor->nTimer)
+    {
+        g_source_remove (pMonitor->nTimer);
+        pMonitor->nTimer = 0;
+    }
+
+    g_hash_table_destroy (pMonitor->pSubscribers);
+    idleMonitorUnref (pMonitor);
+}
+
+void idle_monitor_hold (IdleMonitor *pMonitor)
+{
+    pMonitor->nPending++;
+    update (pMonitor);
+}
+
+void idle_monitor_release (IdleMonitor *pMonitor)
+{
+    if (pMonitor->nPending)
+    {
+        pMonitor->nPending--;
+    }
+
+    // Any activity restarts the countdown
+    update (pMonitor);
+}
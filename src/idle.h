@@ -0,0 +1,35 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __INDICATOR_A11Y_IDLE_H__
+#define __INDICATOR_A11Y_IDLE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _IdleMonitor IdleMonitor;
+typedef void (*IdleMonitorFunc) (gpointer pUserData);
+
+IdleMonitor* idle_monitor_new (GDBusConnection *pConnection, const gchar *sMenuPath, guint nTimeout, IdleMonitorFunc pFunc, gpointer pUserData);
+void idle_monitor_free (IdleMonitor *pMonitor);
+void idle_monitor_hold (IdleMonitor *pMonitor);
+void idle_monitor_release (IdleMonitor *pMonitor);
+
+G_END_DECLS
+
+#endif
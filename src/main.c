@@ -19,6 +19,8 @@
 #include <glib/gi18n.h>
 #include <glib-unix.h>
 #include "service.h"
+#include "recorder.h"
+#include "watchdog.h"
 
 static void onNameLost (gpointer instance G_GNUC_UNUSED, gpointer pLoop)
 {
@@ -26,6 +28,12 @@ static void onNameLost (gpointer instance G_GNUC_UNUSED, gpointer pLoop)
     g_main_loop_quit ((GMainLoop*) pLoop);
 }
 
+static void onIdle (gpointer instance G_GNUC_UNUSED, gpointer pLoop)
+{
+    g_message ("Exiting: service has been idle");
+    g_main_loop_quit ((GMainLoop*) pLoop);
+}
+
 static gboolean onQuit (gpointer pData)
 {
     GMainLoop *pLoop = (GMainLoop*) pData;
@@ -34,21 +42,72 @@ static gboolean onQuit (gpointer pData)
     return G_SOURCE_REMOVE;
 }
 
-int main (int argc G_GNUC_UNUSED, char **argv G_GNUC_UNUSED)
+int main (int argc, char **argv)
 {
     setlocale (LC_ALL, "");
     bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
     textdomain (GETTEXT_PACKAGE);
 
+    gint nIdleTimeout = 0;
+    gint nStallThreshold = 100;
+    gboolean bReacquire = FALSE;
+    gchar *sRecord = NULL;
+    GOptionEntry lEntries[] =
+    {
+        {"idle-timeout", 0, 0, G_OPTION_ARG_INT, &nIdleTimeout, "Exit after SECONDS without menu clients or pending requests (for D-Bus activation)", "SECONDS"},
+        {"stall-threshold", 0, 0, G_OPTION_ARG_INT, &nStallThreshold, "Report main loop dispatches taking longer than MS milliseconds, 0 to disable (default: 100)", "MS"},
+        {"reacquire", 0, 0, G_OPTION_ARG_NONE, &bReacquire, "Keep running when the bus name is lost and take it back as soon as it is released", NULL},
+        {"record", 0, 0, G_OPTION_ARG_FILENAME, &sRecord, "Log every incoming event to FILE", "FILE"},
+        {NULL}
+    };
+
+    GError *pError = NULL;
+    GOptionContext *pContext = g_option_context_new (NULL);
+    g_option_context_add_main_entries (pContext, lEntries, NULL);
+
+    if (!g_option_context_parse (pContext, &argc, &argv, &pError))
+    {
+        g_printerr ("%s\n", pError->message);
+        g_error_free (pError);
+        g_option_context_free (pContext);
+
+        return 1;
+    }
+
+    g_option_context_free (pContext);
+
+    if (nStallThreshold > 0)
+    {
+        watchdog_start (NULL, nStallThreshold * 1000);
+    }
+
+    if (sRecord && !recorder_start (sRecord, &pError))
+    {
+        g_printerr ("%s\n", pError->message);
+        g_error_free (pError);
+        g_free (sRecord);
+
+        return 1;
+    }
+
     IndicatorA11yService *pService = indicator_a11y_service_new ();
     GMainLoop *pLoop = g_main_loop_new (NULL, FALSE);
 
+    if (nIdleTimeout > 0)
+    {
+        indicator_a11y_service_set_idle_timeout (pService, nIdleTimeout);
+        g_signal_connect (pService, "idle", G_CALLBACK (onIdle), pLoop);
+    }
+
+    indicator_a11y_service_set_reacquire (pService, bReacquire);
     g_signal_connect (pService, "name-lost", G_CALLBACK (onNameLost), pLoop);
     g_unix_signal_add (SIGINT, onQuit, pLoop);
 
     g_main_loop_run (pLoop);
     g_main_loop_unref (pLoop);
     g_clear_object (&pService);
+    recorder_stop ();
+    g_free (sRecord);
 
     return 0;
 }
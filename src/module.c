@@ -0,0 +1,54 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <glib/gi18n-lib.h>
+#include <gmodule.h>
+#include "module.h"
+#include "service.h"
+
+// The module is built with hidden visibility, and G_MODULE_EXPORT only implies default visibility on ELF since GLib 2.76
+#define MODULE_EXPORT G_MODULE_EXPORT __attribute__((visibility ("default")))
+
+// The host owns the main context, the session bus connection and the process locale
+
+MODULE_EXPORT const gchar* g_module_check_init (GModule *pModule)
+{
+    // Our GTypes are registered once per process and can never be unregistered, so the code must stay mapped
+    g_module_make_resident (pModule);
+
+    return NULL;
+}
+
+MODULE_EXPORT guint indicator_module_get_abi_version ()
+{
+    return INDICATOR_MODULE_ABI_VERSION;
+}
+
+MODULE_EXPORT const gchar* indicator_module_get_name ()
+{
+    return "org.ayatana.indicator.a11y";
+}
+
+MODULE_EXPORT GObject* indicator_module_create ()
+{
+    bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
+    bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+
+    IndicatorA11yService *pService = indicator_a11y_service_new ();
+
+    return G_OBJECT (pService);
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __INDICATOR_A11Y_MODULE_H__
+#define __INDICATOR_A11Y_MODULE_H__
+
+#include <glib.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+// Bumped whenever the signature or semantics of an entry point change
+#define INDICATOR_MODULE_ABI_VERSION 1
+
+guint indicator_module_get_abi_version ();
+const gchar* indicator_module_get_name ();
+GObject* indicator_module_create ();
+
+G_END_DECLS
+
+#endif
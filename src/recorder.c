@@ -0,0 +1,197 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include "recorder.h"
+
+#define RECORDER_MAGIC 0x52313141
+#define RECORDER_VERSION 1
+
+// On-disk layout: a file header, then one record header per event followed by the name and the value serialised as "v"
+typedef struct
+{
+    guint32 nMagic;
+    guint32 nVersion;
+} RecorderHeader;
+
+typedef struct
+{
+    gint64 nTime;
+    guint32 nValue;
+    guint16 nName;
+    guint8 nEvent;
+    guint8 nReserved;
+} RecorderRecord;
+
+struct _RecorderLog
+{
+    GMappedFile *pFile;
+    gsize nOffset;
+};
+
+static FILE *m_pFile = NULL;
+static gint64 m_nStart = 0;
+
+gboolean recorder_start (const gchar *sPath, GError **pError)
+{
+    FILE *pFile = g_fopen (sPath, "wb");
+
+    if (!pFile)
+    {
+        gint nError = errno;
+        g_set_error (pError, G_FILE_ERROR, g_file_error_from_errno (nError), "Cannot open %s: %s", sPath, g_strerror (nError));
+
+        return FALSE;
+    }
+
+    RecorderHeader cHeader = {RECORDER_MAGIC, RECORDER_VERSION};
+    fwrite (&cHeader, sizeof (RecorderHeader), 1, pFile);
+    recorder_stop ();
+    m_pFile = pFile;
+    m_nStart = g_get_monotonic_time ();
+
+    return TRUE;
+}
+
+void recorder_stop ()
+{
+    if (m_pFile)
+    {
+        fclose (m_pFile);
+        m_pFile = NULL;
+    }
+}
+
+void recorder_event (RecorderEvent eEvent, const gchar *sName, GVariant *pValue)
+{
+    // The value stays the caller's, nothing is touched unless we are recording
+    if (!m_pFile)
+    {
+        return;
+    }
+
+    GVariant *pWrapped = NULL;
+    RecorderRecord cRecord = {g_get_monotonic_time () - m_nStart, 0, strlen (sName), eEvent, 0};
+
+    if (pValue)
+    {
+        pWrapped = g_variant_ref_sink (g_variant_new_variant (pValue));
+        cRecord.nValue = g_variant_get_size (pWrapped);
+    }
+
+    fwrite (&cRecord, sizeof (RecorderRecord), 1, m_pFile);
+    fwrite (sName, 1, cRecord.nName, m_pFile);
+
+    if (pWrapped)
+    {
+        fwrite (g_variant_get_data (pWrapped), 1, cRecord.nValue, m_pFile);
+        g_variant_unref (pWrapped);
+    }
+
+    // Keep what we have if the session ends badly
+    fflush (m_pFile);
+}
+
+RecorderLog* recorder_log_open (const gchar *sPath, GError **pError)
+{
+    GMappedFile *pFile = g_mapped_file_new (sPath, FALSE, pError);
+
+    if (!pFile)
+    {
+        return NULL;
+    }
+
+    RecorderHeader cHeader = {0, 0};
+
+    if (g_mapped_file_get_length (pFile) >= sizeof (RecorderHeader))
+    {
+        memcpy (&cHeader, g_mapped_file_get_contents (pFile), sizeof (RecorderHeader));
+    }
+
+    if (cHeader.nMagic != RECORDER_MAGIC || cHeader.nVersion != RECORDER_VERSION)
+    {
+        g_set_error (pError, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s is not a recording or has an unsupported version", sPath);
+        g_mapped_file_unref (pFile);
+
+        return NULL;
+    }
+
+    RecorderLog *pLog = g_new0 (RecorderLog, 1);
+    pLog->pFile = pFile;
+    pLog->nOffset = sizeof (RecorderHeader);
+
+    return pLog;
+}
+
+gboolean recorder_log_next (RecorderLog *pLog, RecorderEntry *pEntry)
+{
+    memset (pEntry, 0, sizeof (RecorderEntry));
+
+    gsize nLength = g_mapped_file_get_length (pLog->pFile);
+    const gchar *sData = g_mapped_file_get_contents (pLog->pFile);
+    RecorderRecord cRecord;
+
+    if (nLength - pLog->nOffset < sizeof (RecorderRecord))
+    {
+        return FALSE;
+    }
+
+    memcpy (&cRecord, sData + pLog->nOffset, sizeof (RecorderRecord));
+    gsize nOffset = pLog->nOffset + sizeof (RecorderRecord);
+
+    // A truncated tail is where the recording was cut off
+    if (cRecord.nEvent >= RECORDER_EVENTS || nLength - nOffset < (gsize) cRecord.nName + cRecord.nValue)
+    {
+        g_warning ("Recording ends with an incomplete event");
+
+        return FALSE;
+    }
+
+    pEntry->nTime = cRecord.nTime;
+    pEntry->eEvent = cRecord.nEvent;
+    pEntry->sName = g_strndup (sData + nOffset, cRecord.nName);
+    nOffset += cRecord.nName;
+
+    if (cRecord.nValue)
+    {
+        // Copied, the mapping gives no alignment guarantees
+        GBytes *pBytes = g_bytes_new (sData + nOffset, cRecord.nValue);
+        GVariant *pWrapped = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE_VARIANT, pBytes, FALSE));
+        pEntry->pValue = g_variant_get_variant (pWrapped);
+        g_variant_unref (pWrapped);
+        g_bytes_unref (pBytes);
+        nOffset += cRecord.nValue;
+    }
+
+    pLog->nOffset = nOffset;
+
+    return TRUE;
+}
+
+void recorder_log_free (RecorderLog *pLog)
+{
+    g_mapped_file_unref (pLog->pFile);
+    g_free (pLog);
+}
+
+void recorder_entry_clear (RecorderEntry *pEntry)
+{
+    g_clear_pointer (&pEntry->sName, g_free);
+    g_clear_pointer (&pEntry->pValue, g_variant_unref);
+}
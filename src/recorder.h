@@ -0,0 +1,55 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INDICATOR_A11Y_RECORDER_H__
+#define __INDICATOR_A11Y_RECORDER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    RECORDER_ONBOARD,
+    RECORDER_SETTINGS,
+    RECORDER_BACKEND,
+    RECORDER_ACTIVATE,
+    RECORDER_CHANGE_STATE,
+    RECORDER_EVENTS
+} RecorderEvent;
+
+// Times are in microseconds since the recording started
+typedef struct
+{
+    gint64 nTime;
+    RecorderEvent eEvent;
+    gchar *sName;
+    GVariant *pValue;
+} RecorderEntry;
+
+typedef struct _RecorderLog RecorderLog;
+
+gboolean recorder_start (const gchar *sPath, GError **pError);
+void recorder_stop ();
+void recorder_event (RecorderEvent eEvent, const gchar *sName, GVariant *pValue);
+RecorderLog* recorder_log_open (const gchar *sPath, GError **pError);
+gboolean recorder_log_next (RecorderLog *pLog, RecorderEntry *pEntry);
+void recorder_log_free (RecorderLog *pLog);
+void recorder_entry_clear (RecorderEntry *pEntry);
+
+G_END_DECLS
+
+#endif
@@ -14,14 +14,89 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <glib/gi18n.h>
+#include <glib/gi18n-lib.h>
 #include <gio/gio.h>
 #include "service.h"
+#include "backend.h"
+#include "greeter.h"
+#include "idle.h"
+#include "recorder.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "throttle.h"
+#include "trace.h"
 
 #define BUS_NAME "org.ayatana.indicator.a11y"
 #define BUS_PATH "/org/ayatana/indicator/a11y"
+#define CALL_TIMEOUT 5000
+#define SLIDER_RATE 10
 
 static guint m_nSignal = 0;
+static guint m_nIdleSignal = 0;
+
+typedef enum
+{
+    FEATURE_CONTRAST,
+    FEATURE_ONBOARD,
+    FEATURE_ORCA,
+    FEATURE_STICKY_KEYS,
+    FEATURE_SLOW_KEYS,
+    FEATURE_BOUNCE_KEYS,
+    FEATURE_MOUSE_KEYS,
+    FEATURES
+} Feature;
+
+typedef void (*IntentApplyFunc) (IndicatorA11yService *self, Feature eFeature, gboolean bActive);
+
+// Last-writer-wins toggle state of a single action
+typedef struct
+{
+    IndicatorA11yService *pService;
+    Feature eFeature;
+    GSimpleAction *pAction;
+    IntentApplyFunc pApply;
+    GSettings *pSettings;
+    gboolean bApplied;
+    gboolean bDesired;
+    gboolean bRequested;
+    gboolean bInFlight;
+    gint64 nDesired;
+    gint64 nRequested;
+} Intent;
+
+typedef enum
+{
+    SLIDER_MAGNIFIER,
+    SLIDER_TEXT_SCALING,
+    SLIDERS
+} SliderIndex;
+
+// A continuous setting, written at most SLIDER_RATE times per second
+typedef struct
+{
+    IndicatorA11yService *pService;
+    SliderIndex eSlider;
+    GSimpleAction *pAction;
+    GSettings *pSettings;
+    Throttle *pThrottle;
+} Slider;
+
+// One GSettings object and one changed handler per schema, however many switches it carries
+typedef struct
+{
+    IndicatorA11yService *pService;
+    const gchar *sSchema;
+    GSettings *pSettings;
+    GHashTable *pKeys;
+} SettingsSource;
+
+// Shared with the GDBus worker thread, which only sees the service through a weak reference
+typedef struct
+{
+    GWeakRef cService;
+    GMainContext *pContext;
+    gint nQueued;
+} DescribeWatch;
 
 struct _IndicatorA11yServicePrivate
 {
@@ -34,33 +109,208 @@ struct _IndicatorA11yServicePrivate
     GMenu *pSubmenu;
     guint nExportId;
     GSimpleAction *pHeaderAction;
+    guint nOnboardWatch;
     guint nOnboardSubscription;
-    gboolean bOnboardActive;
-    GSettings *pOrcaSettings;
-    guint nOrcaSubscription;
-    gboolean bOrcaActive;
-    gboolean bHighContrast;
-    GSettings *pHighContrastSettings;
-    gboolean bIgnoreSettings;
-    gchar *sThemeGtk;
-    gchar *sThemeIcon;
+    GHashTable *pOnboardProperties;
+    guint nOnboardIdle;
+    gboolean bOnboardVisible;
+    gboolean bOnboardHint;
+    SettingsSource lSources[FEATURES];
+    guint nSources;
+    Intent lIntents[FEATURES];
+    Slider lSliders[SLIDERS];
+    BackendType eBackend;
+    Backend *pBackend;
     gboolean bGreeter;
+    GCancellable *pCancellable;
+    GreeterBridge *pGreeter;
+    gboolean bBackendsLoaded;
+    guint nDescribeFilter;
+    gint64 nStartTime;
+    guint nIdleTimeout;
+    IdleMonitor *pIdleMonitor;
+    Snapshot cSnapshot;
+    guint nSnapshotIdle;
+    guint nStatsId;
+    gint64 nOnboardCallStart;
+    gint nProfile;
+    gint64 nProfileStart;
+    gboolean bReacquire;
+    gint64 nLostTime;
+    GMenu *pSection;
+    gboolean lShown[FEATURES];
+    guint nInstalled;
+    GVariant *lHeaders[2];
+    gboolean bHeaderActive;
 };
 
 typedef IndicatorA11yServicePrivate priv_t;
 
 G_DEFINE_TYPE_WITH_PRIVATE (IndicatorA11yService, indicator_a11y_service, G_TYPE_OBJECT)
 
-static GVariant* createHeaderState (IndicatorA11yService *self)
+static void loadBackends (IndicatorA11yService *self);
+static void applyContrast (IndicatorA11yService *self, Feature eFeature, gboolean bActive);
+static void applyOnboard (IndicatorA11yService *self, Feature eFeature, gboolean bActive);
+static void applyOrca (IndicatorA11yService *self, Feature eFeature, gboolean bActive);
+static void applySettings (IndicatorA11yService *self, Feature eFeature, gboolean bActive);
+
+// One switch in the menu, addressed by its index everywhere else
+typedef struct
+{
+    const gchar *sAction;
+    const gchar *sLabel;
+    IntentApplyFunc pApply;
+    guint32 nSnapshotFlag;
+    gboolean bGreeter;
+    const gchar *sSchema;
+    const gchar *sMateSchema;
+    const gchar *sKey;
+    const gchar *sProgram;
+    const gchar *sGreeterMethod;
+} FeatureInfo;
+
+static const FeatureInfo m_lFeatures[FEATURES] =
+{
+    {"contrast", N_("High Contrast"), applyContrast, SNAPSHOT_CONTRAST, FALSE, NULL, NULL, NULL, NULL, NULL},
+    {"onboard", N_("On-Screen Keyboard"), applyOnboard, SNAPSHOT_ONBOARD, TRUE, NULL, NULL, NULL, "onboard", "ToggleOnBoard"},
+    {"orca", N_("Screen Reader"), applyOrca, SNAPSHOT_ORCA, TRUE, "org.gnome.desktop.a11y.applications", NULL, "screen-reader-enabled", "orca", "ToggleOrca"},
+    {"sticky-keys", N_("Sticky Keys"), applySettings, SNAPSHOT_STICKY_KEYS, FALSE, "org.gnome.desktop.a11y.keyboard", "org.mate.accessibility-keyboard", "stickykeys-enable", NULL, NULL},
+    {"slow-keys", N_("Slow Keys"), applySettings, SNAPSHOT_SLOW_KEYS, FALSE, "org.gnome.desktop.a11y.keyboard", "org.mate.accessibility-keyboard", "slowkeys-enable", NULL, NULL},
+    {"bounce-keys", N_("Bounce Keys"), applySettings, SNAPSHOT_BOUNCE_KEYS, FALSE, "org.gnome.desktop.a11y.keyboard", "org.mate.accessibility-keyboard", "bouncekeys-enable", NULL, NULL},
+    {"mouse-keys", N_("Mouse Keys"), applySettings, SNAPSHOT_MOUSE_KEYS, FALSE, "org.gnome.desktop.a11y.keyboard", "org.mate.accessibility-keyboard", "mousekeys-enable", NULL, NULL}
+};
+
+typedef struct
+{
+    const gchar *sAction;
+    const gchar *sLabel;
+    const gchar *sSchema;
+    const gchar *sKey;
+    gdouble fMin;
+    gdouble fMax;
+    gdouble fStep;
+    guchar nDigits;
+} SliderInfo;
+
+static const SliderInfo m_lSliders[SLIDERS] =
+{
+    {"magnifier", N_("Zoom"), "org.gnome.desktop.a11y.magnifier", "mag-factor", 1.0, 16.0, 0.25, 2},
+    {"text-scaling", N_("Text Size"), "org.gnome.desktop.interface", "text-scaling-factor", 0.5, 3.0, 0.05, 2}
+};
+
+// A set of feature states and slider values applied in one go
+typedef struct
+{
+    const gchar *sName;
+    const gchar *sLabel;
+    gboolean lFeatures[FEATURES];
+    gdouble lSliders[SLIDERS];
+} ProfileInfo;
+
+static const ProfileInfo m_lProfiles[] =
+{
+    {"default", N_("Default"), {FALSE, FALSE, FALSE, FALSE, FALSE, FALSE, FALSE}, {1.0, 1.0}},
+    {"low-vision", N_("Low Vision"), {TRUE, FALSE, FALSE, FALSE, FALSE, FALSE, FALSE}, {2.0, 1.5}},
+    {"blindness", N_("Blindness"), {FALSE, FALSE, TRUE, FALSE, FALSE, FALSE, FALSE}, {1.0, 1.0}},
+    {"dexterity", N_("Limited Dexterity"), {FALSE, TRUE, FALSE, TRUE, FALSE, FALSE, FALSE}, {1.0, 1.0}}
+};
+
+static gboolean getActionState (GSimpleAction *pAction)
+{
+    if (!pAction)
+    {
+        return FALSE;
+    }
+
+    GVariant *pState = g_action_get_state (G_ACTION (pAction));
+    gboolean bActive = g_variant_get_boolean (pState);
+    g_variant_unref (pState);
+
+    return bActive;
+}
+
+static gboolean onSaveSnapshot (gpointer pData)
+{
+    TRACE_ENTER ("onSaveSnapshot", NULL, -1);
+
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
+    self->pPrivate->nSnapshotIdle = 0;
+
+    // Keep the themes of the last snapshot until the backend knows better
+    Snapshot *pLast = &self->pPrivate->cSnapshot;
+    Snapshot cSnapshot = {0, pLast->sThemeGtk, pLast->sThemeIcon};
+
+    if (self->pPrivate->pBackend)
+    {
+        cSnapshot.sThemeGtk = (gchar*) backend_get_theme_gtk (self->pPrivate->pBackend);
+        cSnapshot.sThemeIcon = (gchar*) backend_get_theme_icon (self->pPrivate->pBackend);
+    }
+
+    for (guint nFeature = 0; nFeature < FEATURES; nFeature++)
+    {
+        if (getActionState (self->pPrivate->lIntents[nFeature].pAction))
+        {
+            cSnapshot.nFlags |= m_lFeatures[nFeature].nSnapshotFlag;
+        }
+    }
+
+    if (self->pPrivate->nOnboardSubscription)
+    {
+        cSnapshot.nFlags |= SNAPSHOT_ONBOARD_AVAILABLE;
+    }
+
+    if (self->pPrivate->pGreeter && greeter_bridge_is_available (self->pPrivate->pGreeter, m_lFeatures[FEATURE_ONBOARD].sGreeterMethod) && greeter_bridge_is_available (self->pPrivate->pGreeter, m_lFeatures[FEATURE_ORCA].sGreeterMethod) && g_action_get_enabled (G_ACTION (self->pPrivate->lIntents[FEATURE_ONBOARD].pAction)) && g_action_get_enabled (G_ACTION (self->pPrivate->lIntents[FEATURE_ORCA].pAction)))
+    {
+        cSnapshot.nFlags |= SNAPSHOT_GREETER_AVAILABLE;
+    }
+
+    // Skip the write if nothing changed since the last one
+    if (cSnapshot.nFlags != pLast->nFlags || g_strcmp0 (cSnapshot.sThemeGtk, pLast->sThemeGtk) != 0 || g_strcmp0 (cSnapshot.sThemeIcon, pLast->sThemeIcon) != 0)
+    {
+        if (snapshot_save (&cSnapshot))
+        {
+            gchar *sThemeGtk = g_strdup (cSnapshot.sThemeGtk);
+            gchar *sThemeIcon = g_strdup (cSnapshot.sThemeIcon);
+            snapshot_clear (pLast);
+            pLast->nFlags = cSnapshot.nFlags;
+            pLast->sThemeGtk = sThemeGtk;
+            pLast->sThemeIcon = sThemeIcon;
+        }
+    }
+
+    TRACE_LEAVE ("onSaveSnapshot", NULL, -1);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void saveSnapshot (IndicatorA11yService *self)
+{
+    if (!self->pPrivate->nSnapshotIdle)
+    {
+        self->pPrivate->nSnapshotIdle = g_idle_add_full (G_PRIORITY_LOW, onSaveSnapshot, self, NULL);
+    }
+}
+
+static GVariant* createHeaderState (gboolean bActive)
 {
+    const gchar *sIcon = "preferences-desktop-accessibility-panel";
+    const gchar *sDescription = _("Accessibility settings");
+
+    // We install the active variant into hicolor, so themes that only restyle the plain icon still show the difference
+    if (bActive)
+    {
+        sIcon = "preferences-desktop-accessibility-panel-active";
+        sDescription = _("Accessibility settings, features are active");
+    }
+
     GVariantBuilder cBuilder;
     g_variant_builder_init (&cBuilder, G_VARIANT_TYPE ("a{sv}"));
     g_variant_builder_add (&cBuilder, "{sv}", "title", g_variant_new_string (_("Accessibility")));
     g_variant_builder_add (&cBuilder, "{sv}", "tooltip", g_variant_new_string (_("Accessibility settings")));
     g_variant_builder_add (&cBuilder, "{sv}", "visible", g_variant_new_boolean (TRUE));
-    g_variant_builder_add (&cBuilder, "{sv}", "accessible-desc", g_variant_new_string (_("Accessibility settings")));
+    g_variant_builder_add (&cBuilder, "{sv}", "accessible-desc", g_variant_new_string (sDescription));
 
-    GIcon *pIcon = g_themed_icon_new_with_default_fallbacks ("preferences-desktop-accessibility-panel");
+    GIcon *pIcon = g_themed_icon_new_with_default_fallbacks (sIcon);
     GVariant *pSerialized = g_icon_serialize (pIcon);
 
     if (pSerialized != NULL)
@@ -71,441 +321,1353 @@ static GVariant* createHeaderState (IndicatorA11yService *self)
 
     g_object_unref (pIcon);
 
-    return g_variant_builder_end (&cBuilder);
+    return g_variant_ref_sink (g_variant_builder_end (&cBuilder));
+}
+
+static void updateHeader (IndicatorA11yService *self)
+{
+    gboolean bActive = FALSE;
+
+    for (guint nFeature = 0; nFeature < FEATURES && !bActive; nFeature++)
+    {
+        bActive = getActionState (self->pPrivate->lIntents[nFeature].pAction);
+    }
+
+    // Both states are built once, only swap them when the combined state flips
+    if (bActive != self->pPrivate->bHeaderActive)
+    {
+        self->pPrivate->bHeaderActive = bActive;
+        g_simple_action_set_state (self->pPrivate->pHeaderAction, self->pPrivate->lHeaders[bActive]);
+    }
+}
+
+static void onActionState (GObject *pObject, GParamSpec *pSpec, gpointer pData)
+{
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
+    updateHeader (self);
+    saveSnapshot (self);
+}
+
+static gboolean isAvailable (IndicatorA11yService *self, Feature eFeature)
+{
+    const FeatureInfo *pInfo = &m_lFeatures[eFeature];
+
+    if (self->pPrivate->bGreeter)
+    {
+        if (!pInfo->bGreeter || (self->pPrivate->pGreeter && !greeter_bridge_is_available (self->pPrivate->pGreeter, pInfo->sGreeterMethod)))
+        {
+            return FALSE;
+        }
+    }
+
+    // A running Onboard counts even when it is not in our PATH, the snapshot speaks for it until the bus watch reports
+    if (eFeature == FEATURE_ONBOARD && (self->pPrivate->nOnboardSubscription || self->pPrivate->bOnboardHint))
+    {
+        return TRUE;
+    }
+
+    return (self->pPrivate->nInstalled & (1 << eFeature)) != 0;
+}
+
+static void updateSection (IndicatorA11yService *self)
+{
+    guint nPosition = 0;
+
+    // Insert or remove single rows, the exporter sends these as small items-changed deltas
+    for (guint nFeature = 0; nFeature < FEATURES; nFeature++)
+    {
+        gboolean bAvailable = isAvailable (self, nFeature);
+
+        if (bAvailable && !self->pPrivate->lShown[nFeature])
+        {
+            gchar *sAction = g_strconcat ("indicator.", m_lFeatures[nFeature].sAction, NULL);
+            GMenuItem *pItem = g_menu_item_new (_(m_lFeatures[nFeature].sLabel), sAction);
+            g_menu_item_set_attribute (pItem, "x-ayatana-type", "s", "org.ayatana.indicator.switch");
+            g_menu_insert_item (self->pPrivate->pSection, nPosition, pItem);
+            g_object_unref (pItem);
+            g_free (sAction);
+        }
+        else if (!bAvailable && self->pPrivate->lShown[nFeature])
+        {
+            g_menu_remove (self->pPrivate->pSection, nPosition);
+        }
+
+        self->pPrivate->lShown[nFeature] = bAvailable;
+
+        if (bAvailable)
+        {
+            nPosition++;
+        }
+    }
+}
+
+static void onProbeHelpers (GTask *pTask, gpointer pSource, gpointer pData, GCancellable *pCancellable)
+{
+    gssize nInstalled = 0;
+
+    for (guint nFeature = 0; nFeature < FEATURES; nFeature++)
+    {
+        const gchar *sProgram = m_lFeatures[nFeature].sProgram;
+
+        if (!sProgram)
+        {
+            nInstalled |= 1 << nFeature;
+
+            continue;
+        }
+
+        gchar *sPath = g_find_program_in_path (sProgram);
+
+        if (sPath)
+        {
+            nInstalled |= 1 << nFeature;
+            g_free (sPath);
+        }
+    }
+
+    g_task_return_int (pTask, nInstalled);
+}
+
+static void onHelpersProbed (GObject *pObject, GAsyncResult *pResult, gpointer pData)
+{
+    GError *pError = NULL;
+    gssize nInstalled = g_task_propagate_int (G_TASK (pResult), &pError);
+
+    if (pError)
+    {
+        g_error_free (pError);
+
+        return;
+    }
+
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pObject);
+
+    g_debug ("helpers probed after %" G_GINT64_FORMAT " us", g_get_monotonic_time () - self->pPrivate->nStartTime);
+
+    self->pPrivate->nInstalled = nInstalled;
+    updateSection (self);
+}
+
+static void profileDone (IndicatorA11yService *self)
+{
+    if (self->pPrivate->nProfile < 0)
+    {
+        return;
+    }
+
+    for (guint nFeature = 0; nFeature < FEATURES; nFeature++)
+    {
+        if (self->pPrivate->lIntents[nFeature].bInFlight)
+        {
+            return;
+        }
+    }
+
+    // Every side effect of the profile has been acknowledged
+    gint64 nDuration = g_get_monotonic_time () - self->pPrivate->nProfileStart;
+    stats_latency (STATS_LATENCY_PROFILE, nDuration);
+    g_debug ("profile %s applied after %" G_GINT64_FORMAT " us", m_lProfiles[self->pPrivate->nProfile].sName, nDuration);
+    self->pPrivate->nProfile = -1;
+}
+
+static void intentDispatch (IndicatorA11yService *self, Intent *pIntent)
+{
+    if (pIntent->bInFlight || pIntent->bDesired == pIntent->bApplied)
+    {
+        return;
+    }
+
+    pIntent->bInFlight = TRUE;
+    pIntent->bRequested = pIntent->bDesired;
+
+    if (self->pPrivate->pIdleMonitor)
+    {
+        idle_monitor_hold (self->pPrivate->pIdleMonitor);
+    }
+
+    pIntent->nRequested = pIntent->nDesired;
+    pIntent->pApply (self, pIntent->eFeature, pIntent->bRequested);
+}
+
+static void intentRequest (IndicatorA11yService *self, Intent *pIntent, gboolean bActive)
+{
+    // Only the newest state is kept while a request is in flight
+    pIntent->bDesired = bActive;
+    pIntent->nDesired = g_get_monotonic_time ();
+    intentDispatch (self, pIntent);
+}
+
+static void intentComplete (IndicatorA11yService *self, Intent *pIntent, gboolean bSuccess)
+{
+    pIntent->bInFlight = FALSE;
+
+    // Time from the state change request to the backend acknowledging it
+    gint64 nLatency = g_get_monotonic_time () - pIntent->nRequested;
+    g_debug ("%s %s after %" G_GINT64_FORMAT " us", m_lFeatures[pIntent->eFeature].sAction, bSuccess ? "applied" : "failed", nLatency);
+
+    if (bSuccess)
+    {
+        pIntent->bApplied = pIntent->bRequested;
+    }
+    else
+    {
+        // Drop whatever was queued and roll back to the last known state
+        pIntent->bDesired = pIntent->bApplied;
+        g_simple_action_set_state (pIntent->pAction, g_variant_new_boolean (pIntent->bApplied));
+    }
+
+    if (self->pPrivate->pIdleMonitor)
+    {
+        idle_monitor_release (self->pPrivate->pIdleMonitor);
+    }
+
+    intentDispatch (self, pIntent);
+    profileDone (self);
+}
+
+static void intentSync (IndicatorA11yService *self, Intent *pIntent, gboolean bActive)
+{
+    // The backend changed behind our back
+    pIntent->bApplied = bActive;
+
+    if (!pIntent->bInFlight && pIntent->bDesired != bActive)
+    {
+        pIntent->bDesired = bActive;
+        g_simple_action_set_state (pIntent->pAction, g_variant_new_boolean (bActive));
+    }
+}
+
+static gboolean mirrorOnboard (IndicatorA11yService *self, GVariant *pDict, gboolean *pVisible)
+{
+    GVariantIter cIter;
+    gchar *sKey = NULL;
+    GVariant *pValue = NULL;
+
+    g_variant_iter_init (&cIter, pDict);
+
+    while (g_variant_iter_next (&cIter, "{sv}", &sKey, &pValue))
+    {
+        g_hash_table_replace (self->pPrivate->pOnboardProperties, sKey, pValue);
+    }
+
+    return g_variant_lookup (pDict, "Visible", "b", pVisible);
+}
+
+static gboolean onOnboardVisible (gpointer pData)
+{
+    TRACE_ENTER ("onOnboardVisible", "onboard", -1);
+
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
+    self->pPrivate->nOnboardIdle = 0;
+    intentSync (self, &self->pPrivate->lIntents[FEATURE_ONBOARD], self->pPrivate->bOnboardVisible);
+    TRACE_LEAVE ("onOnboardVisible", "onboard", self->pPrivate->lIntents[FEATURE_ONBOARD].bApplied);
+
+    return G_SOURCE_REMOVE;
 }
 
 static void onOnboardBus (GDBusConnection *pConnection, const gchar *sSender, const gchar *sPath, const gchar *sInterface, const gchar *sSignal, GVariant *pParameters, gpointer pUserData)
 {
+    TRACE_ENTER ("onOnboardBus", "onboard", -1);
+
+    stats_count (STATS_ONBOARD_SIGNALS);
+    recorder_event (RECORDER_ONBOARD, sSignal, pParameters);
+
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pUserData);
     GVariant *pDict = g_variant_get_child_value (pParameters, 1);
-    GVariant* pValue = g_variant_lookup_value (pDict, "Visible", G_VARIANT_TYPE_BOOLEAN);
+    gboolean bActive = FALSE;
+    gboolean bFound = mirrorOnboard (self, pDict, &bActive);
     g_variant_unref (pDict);
 
+    GVariantIter *pInvalidated = NULL;
+    const gchar *sKey = NULL;
+    g_variant_get_child (pParameters, 2, "as", &pInvalidated);
+
+    while (g_variant_iter_next (pInvalidated, "&s", &sKey))
+    {
+        g_hash_table_remove (self->pPrivate->pOnboardProperties, sKey);
+    }
+
+    g_variant_iter_free (pInvalidated);
+
+    // Ignore changes of other properties, and emit at most once per main loop iteration however many signals arrive
+    if (bFound)
+    {
+        self->pPrivate->bOnboardVisible = bActive;
+
+        if (!self->pPrivate->nOnboardIdle)
+        {
+            self->pPrivate->nOnboardIdle = g_idle_add_full (G_PRIORITY_DEFAULT, onOnboardVisible, self, NULL);
+        }
+    }
+
+    TRACE_LEAVE ("onOnboardBus", "onboard", bActive);
+}
+
+static void onOnboardProperties (GObject *pObject, GAsyncResult *pResult, gpointer pUserData)
+{
+    TRACE_ENTER ("onOnboardProperties", "onboard", -1);
+
+    GError *pError = NULL;
+    GVariant *pRet = g_dbus_connection_call_finish (G_DBUS_CONNECTION (pObject), pResult, &pError);
+
+    if (g_error_matches (pError, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+        g_error_free (pError);
+        TRACE_LEAVE ("onOnboardProperties", "onboard", -1);
+
+        return;
+    }
+
     IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pUserData);
-    gboolean bActive = g_variant_get_boolean (pValue);
 
-    if (bActive != self->pPrivate->bOnboardActive)
+    if (pError)
+    {
+        g_warning ("Failed to get Onboard properties: %s", pError->message);
+        g_error_free (pError);
+    }
+    else
+    {
+        GVariant *pDict = g_variant_get_child_value (pRet, 0);
+        gboolean bActive = FALSE;
+
+        if (mirrorOnboard (self, pDict, &bActive))
+        {
+            intentSync (self, &self->pPrivate->lIntents[FEATURE_ONBOARD], bActive);
+        }
+
+        g_variant_unref (pDict);
+        g_variant_unref (pRet);
+    }
+
+    g_simple_action_set_enabled (self->pPrivate->lIntents[FEATURE_ONBOARD].pAction, TRUE);
+    TRACE_LEAVE ("onOnboardProperties", "onboard", -1);
+}
+
+static void onOnboardAppeared (GDBusConnection *pConnection, const gchar *sName, const gchar *sOwner, gpointer pData)
+{
+    TRACE_ENTER ("onOnboardAppeared", "onboard", -1);
+
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
+
+    g_debug ("%s appeared as %s", sName, sOwner);
+    self->pPrivate->bOnboardHint = FALSE;
+
+    if (!self->pPrivate->nOnboardSubscription)
     {
-        self->pPrivate->bOnboardActive = bActive;
-        GAction *pAction = g_action_map_lookup_action (G_ACTION_MAP (self->pPrivate->pActionGroup), "onboard");
-        g_action_change_state (pAction, pValue);
+        // Only listen to Onboard itself
+        self->pPrivate->nOnboardSubscription = g_dbus_connection_signal_subscribe (pConnection, sOwner, "org.freedesktop.DBus.Properties", "PropertiesChanged", "/org/onboard/Onboard/Keyboard", "org.onboard.Onboard.Keyboard", G_DBUS_SIGNAL_FLAGS_NONE, onOnboardBus, self, NULL);
+        saveSnapshot (self);
+        updateSection (self);
     }
 
-    g_variant_unref (pValue);
+    // The state is unknown until the properties arrive
+    g_simple_action_set_enabled (self->pPrivate->lIntents[FEATURE_ONBOARD].pAction, FALSE);
+    stats_count (STATS_BACKEND_CALLS);
+    g_dbus_connection_call (pConnection, sOwner, "/org/onboard/Onboard/Keyboard", "org.freedesktop.DBus.Properties", "GetAll", g_variant_new ("(s)", "org.onboard.Onboard.Keyboard"), G_VARIANT_TYPE ("(a{sv})"), G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT, self->pPrivate->pCancellable, onOnboardProperties, self);
+    TRACE_LEAVE ("onOnboardAppeared", "onboard", -1);
 }
 
-static void onBusAcquired (GDBusConnection *pConnection, const gchar *sName, gpointer pData)
+static void onOnboardVanished (GDBusConnection *pConnection, const gchar *sName, gpointer pData)
 {
+    TRACE_ENTER ("onOnboardVanished", "onboard", -1);
+
     IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
 
-    g_debug ("bus acquired: %s", sName);
+    g_debug ("%s vanished", sName);
 
-    self->pPrivate->pConnection = (GDBusConnection*) g_object_ref (G_OBJECT (pConnection));
+    if (self->pPrivate->nOnboardSubscription || self->pPrivate->bOnboardHint)
+    {
+        if (self->pPrivate->nOnboardSubscription)
+        {
+            g_dbus_connection_signal_unsubscribe (self->pPrivate->pConnection, self->pPrivate->nOnboardSubscription);
+            self->pPrivate->nOnboardSubscription = 0;
+        }
 
-    GError *pError = NULL;
-    self->pPrivate->nActionsId = g_dbus_connection_export_action_group (pConnection, BUS_PATH, G_ACTION_GROUP (self->pPrivate->pActionGroup), &pError);
+        self->pPrivate->bOnboardHint = FALSE;
+        updateSection (self);
+    }
 
-    // Export the actions
-    if (!self->pPrivate->nActionsId)
+    g_hash_table_remove_all (self->pPrivate->pOnboardProperties);
+    saveSnapshot (self);
+
+    if (self->pPrivate->nOnboardIdle)
+    {
+        g_source_remove (self->pPrivate->nOnboardIdle);
+        self->pPrivate->nOnboardIdle = 0;
+    }
+
+    // No Onboard, no keyboard on screen
+    intentSync (self, &self->pPrivate->lIntents[FEATURE_ONBOARD], FALSE);
+    TRACE_LEAVE ("onOnboardVanished", "onboard", self->pPrivate->lIntents[FEATURE_ONBOARD].bApplied);
+}
+
+static void onGreeterAppeared (GreeterBridge *pBridge, gpointer pUserData)
+{
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pUserData);
+
+    // The bridge has forgotten which methods failed, give the switches back
+    for (guint nFeature = 0; nFeature < FEATURES; nFeature++)
+    {
+        if (m_lFeatures[nFeature].bGreeter && self->pPrivate->lIntents[nFeature].pAction)
+        {
+            g_simple_action_set_enabled (self->pPrivate->lIntents[nFeature].pAction, TRUE);
+        }
+    }
+
+    saveSnapshot (self);
+    updateSection (self);
+}
+
+static void onIdle (gpointer pData)
+{
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
+    g_signal_emit (self, m_nIdleSignal, 0);
+}
+
+static void exportObjects (IndicatorA11yService *self, GDBusConnection *pConnection)
+{
+    GError *pError = NULL;
+    self->pPrivate->nActionsId = g_dbus_connection_export_action_group (pConnection, BUS_PATH, G_ACTION_GROUP (self->pPrivate->pActionGroup), &pError);
+
+    // Export the actions
+    if (!self->pPrivate->nActionsId)
+    {
+        g_warning ("cannot export action group: %s", pError->message);
+        g_clear_error(&pError);
+    }
+
+    // Export the menu
+    gchar *sPath = g_strdup_printf ("%s/desktop", BUS_PATH);
+    self->pPrivate->nExportId = g_dbus_connection_export_menu_model (pConnection, sPath, G_MENU_MODEL (self->pPrivate->pMenu), &pError);
+
+    if (!self->pPrivate->nExportId)
+    {
+        g_warning ("cannot export %s menu: %s", sPath, pError->message);
+        g_clear_error (&pError);
+    }
+
+    g_free (sPath);
+
+#ifdef ENABLE_STATS
+    self->pPrivate->nStatsId = stats_export (pConnection, BUS_PATH, &pError);
+
+    if (!self->pPrivate->nStatsId)
+    {
+        g_warning ("cannot export statistics: %s", pError->message);
+        g_clear_error (&pError);
+    }
+#endif
+}
+
+static gboolean onDescribe (gpointer pData)
+{
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
+    loadBackends (self);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void freeDescribeWatch (gpointer pData)
+{
+    DescribeWatch *pWatch = pData;
+    g_weak_ref_clear (&pWatch->cService);
+    g_main_context_unref (pWatch->pContext);
+    g_free (pWatch);
+}
+
+static GDBusMessage* onActionsMessage (GDBusConnection *pConnection, GDBusMessage *pMessage, gboolean bIncoming, gpointer pData)
+{
+    // Runs in the GDBus worker thread: the first client describing the actions is the first one that needs their real states
+    DescribeWatch *pWatch = pData;
+
+    if (!bIncoming || g_dbus_message_get_message_type (pMessage) != G_DBUS_MESSAGE_TYPE_METHOD_CALL)
+    {
+        return pMessage;
+    }
+
+    if (g_strcmp0 (g_dbus_message_get_interface (pMessage), "org.gtk.Actions") != 0 || g_strcmp0 (g_dbus_message_get_path (pMessage), BUS_PATH) != 0)
+    {
+        return pMessage;
+    }
+
+    const gchar *sMember = g_dbus_message_get_member (pMessage);
+
+    if ((g_strcmp0 (sMember, "Describe") == 0 || g_strcmp0 (sMember, "DescribeAll") == 0) && g_atomic_int_compare_and_exchange (&pWatch->nQueued, 0, 1))
+    {
+        // Queued ahead of the call itself, so the reply already carries the loaded states
+        gpointer pService = g_weak_ref_get (&pWatch->cService);
+
+        if (pService)
+        {
+            g_main_context_invoke_full (pWatch->pContext, G_PRIORITY_DEFAULT, onDescribe, pService, g_object_unref);
+        }
+    }
+
+    return pMessage;
+}
+
+static void onBusAcquired (GDBusConnection *pConnection, const gchar *sName, gpointer pData)
+{
+    TRACE_ENTER ("onBusAcquired", NULL, -1);
+
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
+
+    g_debug ("bus acquired: %s", sName);
+
+    self->pPrivate->pConnection = (GDBusConnection*) g_object_ref (G_OBJECT (pConnection));
+    exportObjects (self, pConnection);
+
+    if (!self->pPrivate->bBackendsLoaded)
+    {
+        DescribeWatch *pWatch = g_new0 (DescribeWatch, 1);
+        g_weak_ref_init (&pWatch->cService, self);
+        pWatch->pContext = g_main_context_ref_thread_default ();
+        self->pPrivate->nDescribeFilter = g_dbus_connection_add_filter (pConnection, onActionsMessage, pWatch, freeDescribeWatch);
+    }
+
+    g_debug ("menu exported after %" G_GINT64_FORMAT " us", g_get_monotonic_time () - self->pPrivate->nStartTime);
+
+    if (self->pPrivate->nIdleTimeout)
+    {
+        // Watch the menu subscriptions, we are D-Bus activated and can go away when nobody needs us
+        gchar *sMenuPath = g_strdup_printf ("%s/desktop", BUS_PATH);
+        self->pPrivate->pIdleMonitor = idle_monitor_new (pConnection, sMenuPath, self->pPrivate->nIdleTimeout, onIdle, self);
+        g_free (sMenuPath);
+    }
+
+    if (self->pPrivate->bGreeter)
+    {
+        gint nTimeout = CALL_TIMEOUT;
+        const gchar *sTimeout = g_getenv ("AYATANA_A11Y_GREETER_TIMEOUT");
+
+        if (sTimeout)
+        {
+            gint64 nValue = g_ascii_strtoll (sTimeout, NULL, 10);
+
+            // Garbage or zero would fail every call at once
+            if (nValue > 0 && nValue <= G_MAXINT)
+            {
+                nTimeout = (gint) nValue;
+            }
+            else
+            {
+                g_warning ("Ignoring invalid AYATANA_A11Y_GREETER_TIMEOUT: %s", sTimeout);
+            }
+        }
+
+        self->pPrivate->pGreeter = greeter_bridge_new (pConnection, nTimeout, onGreeterAppeared, self);
+    }
+    else
+    {
+        // Listen to Onboard messages while Onboard is running
+        self->pPrivate->nOnboardWatch = g_bus_watch_name_on_connection (pConnection, "org.onboard.Onboard", G_BUS_NAME_WATCHER_FLAGS_NONE, onOnboardAppeared, onOnboardVanished, self, NULL);
+    }
+
+    TRACE_LEAVE ("onBusAcquired", NULL, -1);
+}
+
+static void onNameAcquired (GDBusConnection *pConnection, const gchar *sName, gpointer pData)
+{
+    TRACE_ENTER ("onNameAcquired", NULL, -1);
+
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
+
+    if (self->pPrivate->nLostTime)
+    {
+        // Everything is still in memory, put it back on the bus
+        if (!self->pPrivate->nActionsId)
+        {
+            exportObjects (self, pConnection);
+        }
+
+        g_message ("Name re-acquired, recovered after %" G_GINT64_FORMAT " us", g_get_monotonic_time () - self->pPrivate->nLostTime);
+        self->pPrivate->nLostTime = 0;
+    }
+    else
+    {
+        g_debug ("name acquired after %" G_GINT64_FORMAT " us", g_get_monotonic_time () - self->pPrivate->nStartTime);
+    }
+
+    // The backends are loaded by the first client that looks at the actions
+    TRACE_LEAVE ("onNameAcquired", NULL, -1);
+}
+
+static void unexport (IndicatorA11yService *self)
+{
+    // Unexport the menu
+    if (self->pPrivate->nExportId)
+    {
+        g_dbus_connection_unexport_menu_model (self->pPrivate->pConnection, self->pPrivate->nExportId);
+        self->pPrivate->nExportId = 0;
+    }
+
+    // Unexport the statistics
+    if (self->pPrivate->nStatsId)
+    {
+        g_dbus_connection_unregister_object (self->pPrivate->pConnection, self->pPrivate->nStatsId);
+        self->pPrivate->nStatsId = 0;
+    }
+
+    // Unexport the actions
+    if (self->pPrivate->nActionsId)
+    {
+        g_dbus_connection_unexport_action_group (self->pPrivate->pConnection, self->pPrivate->nActionsId);
+        self->pPrivate->nActionsId = 0;
+    }
+}
+
+static void onNameLost (GDBusConnection *pConnection, const gchar *sName, gpointer pData)
+{
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
+
+    g_debug ("%s %s name lost %s", G_STRLOC, G_STRFUNC, sName);
+
+    unexport (self);
+
+    // Our request stays queued on a live connection, wait there until the name is ours again
+    if (self->pPrivate->bReacquire && pConnection && !g_dbus_connection_is_closed (pConnection))
+    {
+        if (!self->pPrivate->nLostTime)
+        {
+            self->pPrivate->nLostTime = g_get_monotonic_time ();
+        }
+
+        g_message ("Lost %s, waiting to re-acquire it", sName);
+
+        return;
+    }
+
+    g_signal_emit (self, m_nSignal, 0);
+}
+
+static void onDispose (GObject *pObject)
+{
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pObject);
+
+    if (self->pPrivate->pIdleMonitor)
+    {
+        idle_monitor_free (self->pPrivate->pIdleMonitor);
+        self->pPrivate->pIdleMonitor = NULL;
+    }
+
+    if (self->pPrivate->nOnboardIdle)
+    {
+        g_source_remove (self->pPrivate->nOnboardIdle);
+        self->pPrivate->nOnboardIdle = 0;
+    }
+
+    if (self->pPrivate->nDescribeFilter)
+    {
+        g_dbus_connection_remove_filter (self->pPrivate->pConnection, self->pPrivate->nDescribeFilter);
+        self->pPrivate->nDescribeFilter = 0;
+    }
+
+    // Flush a pending snapshot
+    if (self->pPrivate->nSnapshotIdle)
+    {
+        g_source_remove (self->pPrivate->nSnapshotIdle);
+        onSaveSnapshot (self);
+    }
+
+    snapshot_clear (&self->pPrivate->cSnapshot);
+
+    if (self->pPrivate->pCancellable)
+    {
+        g_cancellable_cancel (self->pPrivate->pCancellable);
+        g_clear_object (&self->pPrivate->pCancellable);
+    }
+
+    if (self->pPrivate->pGreeter)
+    {
+        greeter_bridge_free (self->pPrivate->pGreeter);
+        self->pPrivate->pGreeter = NULL;
+    }
+
+    if (self->pPrivate->nOnboardWatch)
+    {
+        g_bus_unwatch_name (self->pPrivate->nOnboardWatch);
+        self->pPrivate->nOnboardWatch = 0;
+    }
+
+    if (self->pPrivate->nOnboardSubscription)
+    {
+        g_dbus_connection_signal_unsubscribe (self->pPrivate->pConnection, self->pPrivate->nOnboardSubscription);
+        self->pPrivate->nOnboardSubscription = 0;
+    }
+
+    for (guint nSource = 0; nSource < self->pPrivate->nSources; nSource++)
+    {
+        SettingsSource *pSource = &self->pPrivate->lSources[nSource];
+        g_signal_handlers_disconnect_by_data (pSource->pSettings, pSource);
+        g_clear_object (&pSource->pSettings);
+        g_clear_pointer (&pSource->pKeys, g_hash_table_destroy);
+    }
+
+    self->pPrivate->nSources = 0;
+    g_clear_pointer (&self->pPrivate->pBackend, backend_free);
+
+    for (guint nSlider = 0; nSlider < SLIDERS; nSlider++)
+    {
+        Slider *pSlider = &self->pPrivate->lSliders[nSlider];
+
+        if (pSlider->pSettings)
+        {
+            g_signal_handlers_disconnect_by_data (pSlider->pSettings, pSlider);
+        }
+
+        // Writes the value still held back
+        g_clear_pointer (&pSlider->pThrottle, throttle_free);
+        g_clear_object (&pSlider->pSettings);
+    }
+
+    if (self->pPrivate->nOwnId)
+    {
+        g_bus_unown_name (self->pPrivate->nOwnId);
+        self->pPrivate->nOwnId = 0;
+    }
+
+    unexport (self);
+
+    g_clear_pointer (&self->pPrivate->pOnboardProperties, g_hash_table_destroy);
+
+    // The submenu is owned by the menu
+    self->pPrivate->pSection = NULL;
+    self->pPrivate->pSubmenu = NULL;
+    g_clear_object (&self->pPrivate->pMenu);
+    g_clear_object (&self->pPrivate->pHeaderAction);
+    g_clear_pointer (&self->pPrivate->lHeaders[FALSE], g_variant_unref);
+    g_clear_pointer (&self->pPrivate->lHeaders[TRUE], g_variant_unref);
+    g_clear_object (&self->pPrivate->pActionGroup);
+    g_clear_object (&self->pPrivate->pConnection);
+
+    G_OBJECT_CLASS (indicator_a11y_service_parent_class)->dispose (pObject);
+}
+
+static void onOnboardCall (GObject *pObject, GAsyncResult *pResult, gpointer pUserData)
+{
+    TRACE_ENTER ("onOnboardCall", "onboard", -1);
+
+    GError *pError = NULL;
+    GVariant *pRet = g_dbus_connection_call_finish (G_DBUS_CONNECTION (pObject), pResult, &pError);
+
+    if (pRet)
+    {
+        g_variant_unref (pRet);
+    }
+
+    if (g_error_matches (pError, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+        // The service is being disposed, do not touch it
+        g_error_free (pError);
+        TRACE_LEAVE ("onOnboardCall", "onboard", -1);
+
+        return;
+    }
+
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pUserData);
+    stats_latency (STATS_LATENCY_ONBOARD, g_get_monotonic_time () - self->pPrivate->nOnboardCallStart);
+
+    if (pError)
+    {
+        g_warning ("Failed to toggle Onboard: %s", pError->message);
+        g_error_free (pError);
+        intentComplete (self, &self->pPrivate->lIntents[FEATURE_ONBOARD], FALSE);
+    }
+    else
+    {
+        intentComplete (self, &self->pPrivate->lIntents[FEATURE_ONBOARD], TRUE);
+    }
+
+    TRACE_LEAVE ("onOnboardCall", "onboard", self->pPrivate->lIntents[FEATURE_ONBOARD].bApplied);
+}
+
+static void onGreeterCall (GreeterBridge *pBridge, const gchar *sMethod, gboolean bSuccess, gint64 nLatency, gpointer pUserData)
+{
+    TRACE_ENTER ("onGreeterCall", sMethod, -1);
+
+    stats_latency (STATS_LATENCY_GREETER, nLatency);
+
+    Intent *pIntent = pUserData;
+    IndicatorA11yService *self = pIntent->pService;
+    intentComplete (self, pIntent, bSuccess);
+
+    if (!greeter_bridge_is_available (pBridge, sMethod))
+    {
+        g_simple_action_set_enabled (pIntent->pAction, FALSE);
+        saveSnapshot (self);
+        updateSection (self);
+    }
+
+    TRACE_LEAVE ("onGreeterCall", sMethod, bSuccess);
+}
+
+static void applyOnboard (IndicatorA11yService *self, Feature eFeature, gboolean bActive)
+{
+    if (!self->pPrivate->bGreeter)
+    {
+        GVariant *pVisible = g_hash_table_lookup (self->pPrivate->pOnboardProperties, "Visible");
+
+        // Onboard is already where we want it
+        if (pVisible && g_variant_is_of_type (pVisible, G_VARIANT_TYPE_BOOLEAN) && g_variant_get_boolean (pVisible) == bActive)
+        {
+            intentComplete (self, &self->pPrivate->lIntents[FEATURE_ONBOARD], TRUE);
+
+            return;
+        }
+
+        gchar *sFunction = NULL;
+
+        if (bActive)
+        {
+            sFunction = "Show";
+        }
+        else
+        {
+            sFunction = "Hide";
+        }
+
+        stats_count (STATS_BACKEND_CALLS);
+        self->pPrivate->nOnboardCallStart = g_get_monotonic_time ();
+        g_dbus_connection_call (self->pPrivate->pConnection, "org.onboard.Onboard", "/org/onboard/Onboard/Keyboard", "org.onboard.Onboard.Keyboard", sFunction, NULL, NULL, G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT, self->pPrivate->pCancellable, onOnboardCall, self);
+    }
+    else
     {
-        g_warning ("cannot export action group: %s", pError->message);
-        g_clear_error(&pError);
+        stats_count (STATS_BACKEND_CALLS);
+        greeter_bridge_toggle (self->pPrivate->pGreeter, m_lFeatures[FEATURE_ONBOARD].sGreeterMethod, bActive, onGreeterCall, &self->pPrivate->lIntents[FEATURE_ONBOARD]);
     }
+}
 
-    // Export the menu
-    gchar *sPath = g_strdup_printf ("%s/desktop", BUS_PATH);
-    self->pPrivate->nExportId = g_dbus_connection_export_menu_model (pConnection, sPath, G_MENU_MODEL (self->pPrivate->pMenu), &pError);
-
-    if (!self->pPrivate->nExportId)
+static void applyOrca (IndicatorA11yService *self, Feature eFeature, gboolean bActive)
+{
+    if (self->pPrivate->bGreeter)
     {
-        g_warning ("cannot export %s menu: %s", sPath, pError->message);
-        g_clear_error (&pError);
+        stats_count (STATS_BACKEND_CALLS);
+        greeter_bridge_toggle (self->pPrivate->pGreeter, m_lFeatures[FEATURE_ORCA].sGreeterMethod, bActive, onGreeterCall, &self->pPrivate->lIntents[FEATURE_ORCA]);
     }
+    else
+    {
+        applySettings (self, eFeature, bActive);
+    }
+}
 
-    g_free (sPath);
+static void applySettings (IndicatorA11yService *self, Feature eFeature, gboolean bActive)
+{
+    Intent *pIntent = &self->pPrivate->lIntents[eFeature];
 
-    if (!self->pPrivate->bGreeter)
+    if (!pIntent->pSettings)
     {
-        // Listen to Onboard messages
-        self->pPrivate->nOnboardSubscription = g_dbus_connection_signal_subscribe (self->pPrivate->pConnection, NULL, "org.freedesktop.DBus.Properties", "PropertiesChanged", "/org/onboard/Onboard/Keyboard", "org.onboard.Onboard.Keyboard", G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_NAMESPACE, onOnboardBus, self, NULL);
+        intentComplete (self, pIntent, FALSE);
+
+        return;
     }
+
+    // The change notification comes back through onSettingsChanged and finds the intent settled
+    stats_count (STATS_BACKEND_CALLS);
+    g_settings_set_boolean (pIntent->pSettings, m_lFeatures[eFeature].sKey, bActive);
+    intentComplete (self, pIntent, TRUE);
 }
 
-static void unexport (IndicatorA11yService *self)
+static void onSettingsChanged (GSettings *pSettings, const gchar *sKey, gpointer pUserData)
 {
-    // Unexport the menu
-    if (self->pPrivate->nExportId)
+    SettingsSource *pSource = pUserData;
+    Intent *pIntent = g_hash_table_lookup (pSource->pKeys, sKey);
+
+    stats_count (STATS_SETTINGS_NOTIFICATIONS);
+
+    // Other keys of the schema cost this lookup and nothing more
+    if (!pIntent)
     {
-        g_dbus_connection_unexport_menu_model (self->pPrivate->pConnection, self->pPrivate->nExportId);
-        self->pPrivate->nExportId = 0;
+        return;
     }
 
-    // Unexport the actions
-    if (self->pPrivate->nActionsId)
+    TRACE_ENTER ("onSettingsChanged", m_lFeatures[pIntent->eFeature].sAction, -1);
+
+    GVariant *pValue = g_settings_get_value (pSettings, sKey);
+    gboolean bActive = g_variant_get_boolean (pValue);
+
+    // Our own writes come back while in flight or once applied, a replay must not inject them a second time
+    gboolean bEcho = pIntent->bInFlight ? pIntent->bRequested == bActive : pIntent->bApplied == bActive;
+
+    if (!bEcho)
     {
-        g_dbus_connection_unexport_action_group (self->pPrivate->pConnection, self->pPrivate->nActionsId);
-        self->pPrivate->nActionsId = 0;
+        recorder_event (RECORDER_SETTINGS, sKey, pValue);
     }
+
+    intentSync (pSource->pService, pIntent, bActive);
+    g_variant_unref (pValue);
+    TRACE_LEAVE ("onSettingsChanged", m_lFeatures[pIntent->eFeature].sAction, pIntent->bApplied);
 }
 
-static void onNameLost (GDBusConnection *pConnection, const gchar *sName, gpointer pData)
+static const gchar* getSchema (IndicatorA11yService *self, const FeatureInfo *pInfo)
 {
-    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pData);
-
-    g_debug ("%s %s name lost %s", G_STRLOC, G_STRFUNC, sName);
+    if (pInfo->sMateSchema && self->pPrivate->eBackend == BACKEND_MATE)
+    {
+        return pInfo->sMateSchema;
+    }
 
-    unexport (self);
+    return pInfo->sSchema;
 }
 
-static void onDispose (GObject *pObject)
+static SettingsSource* getSettingsSource (IndicatorA11yService *self, const gchar *sSchema, const gchar *sKey)
 {
-    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pObject);
-
-    if (!self->pPrivate->bGreeter)
+    for (guint nSource = 0; nSource < self->pPrivate->nSources; nSource++)
     {
-        if (self->pPrivate->nOnboardSubscription)
-        {
-            g_dbus_connection_signal_unsubscribe (self->pPrivate->pConnection, self->pPrivate->nOnboardSubscription);
-        }
-
-        if (self->pPrivate->pOrcaSettings)
-        {
-            g_clear_object (&self->pPrivate->pOrcaSettings);
-        }
-
-        if (self->pPrivate->pHighContrastSettings)
-        {
-            g_clear_object (&self->pPrivate->pHighContrastSettings);
-        }
-
-        if (self->pPrivate->sThemeGtk)
-        {
-            g_free (self->pPrivate->sThemeGtk);
-        }
+        SettingsSource *pSource = &self->pPrivate->lSources[nSource];
 
-        if (self->pPrivate->sThemeIcon)
+        if (g_str_equal (pSource->sSchema, sSchema))
         {
-            g_free (self->pPrivate->sThemeIcon);
+            return backend_has_key (sSchema, sKey) ? pSource : NULL;
         }
     }
 
-    if (self->pPrivate->nOwnId)
+    GSettings *pSettings = backend_new_settings (sSchema, sKey);
+
+    if (!pSettings)
     {
-        g_bus_unown_name (self->pPrivate->nOwnId);
-        self->pPrivate->nOwnId = 0;
+        return NULL;
     }
 
-    unexport (self);
-
-    g_clear_object (&self->pPrivate->pHeaderAction);
-    g_clear_object (&self->pPrivate->pActionGroup);
-    g_clear_object (&self->pPrivate->pConnection);
+    SettingsSource *pSource = &self->pPrivate->lSources[self->pPrivate->nSources++];
+    pSource->pService = self;
+    pSource->sSchema = sSchema;
+    pSource->pSettings = pSettings;
+    pSource->pKeys = g_hash_table_new (g_str_hash, g_str_equal);
+    g_signal_connect (pSettings, "changed", G_CALLBACK (onSettingsChanged), pSource);
 
-    G_OBJECT_CLASS (indicator_a11y_service_parent_class)->dispose (pObject);
+    return pSource;
 }
 
-static void onOnboardState (GSimpleAction *pAction, GVariant* pValue, gpointer pUserData)
+static void onBackendApplied (Backend *pBackend, gboolean bSuccess, gpointer pUserData)
 {
-    g_simple_action_set_state (pAction, pValue);
+    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pUserData);
+    intentComplete (self, &self->pPrivate->lIntents[FEATURE_CONTRAST], bSuccess);
+}
 
-    gboolean bActive = g_variant_get_boolean (pValue);
+static void onBackendChanged (Backend *pBackend, gboolean bActive, gpointer pUserData)
+{
     IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pUserData);
+    GVariant *pValue = g_variant_ref_sink (g_variant_new_boolean (bActive));
+    recorder_event (RECORDER_BACKEND, backend_get_name (self->pPrivate->eBackend), pValue);
+    g_variant_unref (pValue);
 
-    if (bActive != self->pPrivate->bOnboardActive)
-    {
-        gchar *sFunction = NULL;
+    // The themes to restore may have changed as well
+    saveSnapshot (self);
+    g_simple_action_set_enabled (self->pPrivate->lIntents[FEATURE_CONTRAST].pAction, backend_is_available (pBackend));
+    intentSync (self, &self->pPrivate->lIntents[FEATURE_CONTRAST], bActive);
+}
 
-        if (bActive)
-        {
-            sFunction = "Show";
-        }
-        else
-        {
-            sFunction = "Hide";
-        }
+static void applyContrast (IndicatorA11yService *self, Feature eFeature, gboolean bActive)
+{
+    if (self->pPrivate->pBackend)
+    {
+        backend_set_contrast (self->pPrivate->pBackend, bActive);
+    }
+    else
+    {
+        intentComplete (self, &self->pPrivate->lIntents[FEATURE_CONTRAST], FALSE);
+    }
+}
 
-        GError *pError = NULL;
+static void onFeatureState (GSimpleAction *pAction, GVariant* pValue, gpointer pUserData)
+{
+    Intent *pIntent = pUserData;
+    gboolean bActive = g_variant_get_boolean (pValue);
+    TRACE_ENTER ("onFeatureState", m_lFeatures[pIntent->eFeature].sAction, bActive);
+    recorder_event (RECORDER_CHANGE_STATE, m_lFeatures[pIntent->eFeature].sAction, pValue);
 
-        if (!self->pPrivate->bGreeter)
-        {
-            g_dbus_connection_call_sync (self->pPrivate->pConnection, "org.onboard.Onboard", "/org/onboard/Onboard/Keyboard", "org.onboard.Onboard.Keyboard", sFunction, NULL, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &pError);
-        }
-        else
-        {
-            GVariant *pParam = g_variant_new ("(b)", bActive);
-            g_dbus_connection_call_sync (self->pPrivate->pConnection, "org.ArcticaProject.ArcticaGreeter", "/org/ArcticaProject/ArcticaGreeter", "org.ArcticaProject.ArcticaGreeter", "ToggleOnBoard", pParam, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &pError);
-        }
+    // Load before the state changes, loading syncs the switches to their settings
+    loadBackends (pIntent->pService);
+    g_simple_action_set_state (pAction, pValue);
+    intentRequest (pIntent->pService, pIntent, bActive);
+    TRACE_LEAVE ("onFeatureState", m_lFeatures[pIntent->eFeature].sAction, pIntent->bDesired);
+}
 
-        if (pError)
-        {
-            g_error ("Panic: Failed to toggle Onboard: %s", pError->message);
-            g_error_free (pError);
+static void onSliderState (GSimpleAction *pAction, GVariant* pValue, gpointer pUserData)
+{
+    Slider *pSlider = pUserData;
+    const SliderInfo *pInfo = &m_lSliders[pSlider->eSlider];
+    TRACE_ENTER ("onSliderState", pInfo->sAction, -1);
+    recorder_event (RECORDER_CHANGE_STATE, pInfo->sAction, pValue);
 
-            return;
-        }
+    gdouble fValue = CLAMP (g_variant_get_double (pValue), pInfo->fMin, pInfo->fMax);
+    GVariant *pState = g_variant_ref_sink (g_variant_new_double (fValue));
+    g_simple_action_set_state (pAction, pState);
 
-        self->pPrivate->bOnboardActive = bActive;
+    if (pSlider->pThrottle)
+    {
+        throttle_write (pSlider->pThrottle, pState);
     }
+
+    g_variant_unref (pState);
+    TRACE_LEAVE ("onSliderState", pInfo->sAction, -1);
 }
 
-static void onOrcaState (GSimpleAction *pAction, GVariant* pValue, gpointer pUserData)
+static void onSliderSettings (GSettings *pSettings, const gchar *sKey, gpointer pUserData)
 {
-    g_simple_action_set_state (pAction, pValue);
+    Slider *pSlider = pUserData;
+    TRACE_ENTER ("onSliderSettings", m_lSliders[pSlider->eSlider].sAction, -1);
 
-    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pUserData);
+    stats_count (STATS_SETTINGS_NOTIFICATIONS);
 
-    if (self->pPrivate->bGreeter)
+    GVariant *pValue = g_settings_get_value (pSettings, sKey);
+
+    // Our own writes come back here, do not move the slider under the user's finger for those, nor record them
+    if (throttle_is_echo (pSlider->pThrottle, pValue))
+    {
+        stats_count (STATS_ECHOES_SUPPRESSED);
+    }
+    else
     {
-        gboolean bActive = g_variant_get_boolean (pValue);
+        // Someone else moved it, their value wins over what is held back
+        recorder_event (RECORDER_SETTINGS, sKey, pValue);
+        throttle_cancel (pSlider->pThrottle);
+        g_simple_action_set_state (pSlider->pAction, pValue);
+    }
 
-        if (bActive != self->pPrivate->bOrcaActive)
-        {
-            GError *pError = NULL;
-            GVariant *pParam = g_variant_new ("(b)", bActive);
-            g_dbus_connection_call_sync (self->pPrivate->pConnection, "org.ArcticaProject.ArcticaGreeter", "/org/ArcticaProject/ArcticaGreeter", "org.ArcticaProject.ArcticaGreeter", "ToggleOrca", pParam, NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, &pError);
+    g_variant_unref (pValue);
 
-            if (pError)
-            {
-                g_error ("Panic: Failed to toggle Orca: %s", pError->message);
-                g_error_free (pError);
+    TRACE_LEAVE ("onSliderSettings", m_lSliders[pSlider->eSlider].sAction, -1);
+}
 
-                return;
-            }
+static void batchSet (GHashTable *pBatches, const gchar *sSchema, const gchar *sKey, GVariant *pValue)
+{
+    GSettings *pSettings = g_hash_table_lookup (pBatches, sSchema);
 
-            self->pPrivate->bOrcaActive = bActive;
-        }
+    if (!pSettings)
+    {
+        pSettings = g_settings_new (sSchema);
+        g_settings_delay (pSettings);
+        g_hash_table_insert (pBatches, (gpointer) sSchema, pSettings);
     }
+
+    g_settings_set_value (pSettings, sKey, pValue);
 }
 
-static void onContrastState (GSimpleAction *pAction, GVariant* pValue, gpointer pUserData)
+static void onBatchContrast (const gchar *sSchema, const gchar *sKey, GVariant *pValue, gpointer pUserData)
 {
-    g_simple_action_set_state (pAction, pValue);
+    batchSet (pUserData, sSchema, sKey, pValue);
+}
+
+static void onProfile (GSimpleAction *pAction, GVariant *pParameter, gpointer pUserData)
+{
+    TRACE_ENTER ("onProfile", "profile", -1);
+    recorder_event (RECORDER_ACTIVATE, "profile", pParameter);
 
     IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pUserData);
+    const gchar *sName = g_variant_get_string (pParameter, NULL);
+    gint nProfile = -1;
 
-    if (!self->pPrivate->bGreeter)
+    for (guint nIndex = 0; nIndex < G_N_ELEMENTS (m_lProfiles); nIndex++)
     {
-        gboolean bActive = g_variant_get_boolean (pValue);
-
-        if (bActive != self->pPrivate->bHighContrast)
+        if (g_str_equal (sName, m_lProfiles[nIndex].sName))
         {
-            self->pPrivate->bIgnoreSettings = TRUE;
+            nProfile = nIndex;
 
-            if (bActive)
-            {
-                g_free (self->pPrivate->sThemeGtk);
-                g_free (self->pPrivate->sThemeIcon);
-                self->pPrivate->sThemeGtk = g_settings_get_string (self->pPrivate->pHighContrastSettings, "gtk-theme");
-                self->pPrivate->sThemeIcon = g_settings_get_string (self->pPrivate->pHighContrastSettings, "icon-theme");
-                g_settings_set_string (self->pPrivate->pHighContrastSettings, "gtk-theme", "ContrastHigh");
-                g_settings_set_string (self->pPrivate->pHighContrastSettings, "icon-theme", "ContrastHigh");
-            }
-            else
-            {
-                g_settings_set_string (self->pPrivate->pHighContrastSettings, "gtk-theme", self->pPrivate->sThemeGtk);
-                g_settings_set_string (self->pPrivate->pHighContrastSettings, "icon-theme", self->pPrivate->sThemeIcon);
-            }
-
-            self->pPrivate->bHighContrast = bActive;
-            self->pPrivate->bIgnoreSettings = FALSE;
+            break;
         }
     }
-}
-
-static void onContrastSettings (GSettings *pSettings, const gchar *sKey, gpointer pUserData)
-{
-    IndicatorA11yService *self = INDICATOR_A11Y_SERVICE (pUserData);
 
-    if (self->pPrivate->bIgnoreSettings)
+    if (nProfile < 0)
     {
+        g_warning ("Unknown profile: %s", sName);
+        TRACE_LEAVE ("onProfile", "profile", -1);
+
         return;
     }
 
-    gboolean bThemeGtk = g_str_equal (sKey, "gtk-theme");
-    gboolean bThemeIcon = g_str_equal (sKey, "icon-theme");
+    loadBackends (self);
+    self->pPrivate->nProfile = nProfile;
+    self->pPrivate->nProfileStart = g_get_monotonic_time ();
+
+    const ProfileInfo *pProfile = &m_lProfiles[nProfile];
+    GHashTable *pBatches = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
 
-    if (bThemeGtk)
+    // GSettings has no transaction across schemas: each schema gets one delayed batch, all committed back to back below
+    for (guint nSlider = 0; nSlider < SLIDERS; nSlider++)
     {
-        g_free (self->pPrivate->sThemeGtk);
-        self->pPrivate->sThemeGtk = g_settings_get_string (self->pPrivate->pHighContrastSettings, "gtk-theme");
+        Slider *pSlider = &self->pPrivate->lSliders[nSlider];
+
+        if (pSlider->pSettings)
+        {
+            throttle_cancel (pSlider->pThrottle);
+            batchSet (pBatches, m_lSliders[nSlider].sSchema, m_lSliders[nSlider].sKey, g_variant_new_double (pProfile->lSliders[nSlider]));
+        }
     }
-    else if (bThemeIcon)
+
+    // D-Bus side effects go out concurrently, each through its own intent
+    for (guint nFeature = 0; nFeature < FEATURES; nFeature++)
     {
-        g_free (self->pPrivate->sThemeIcon);
-        self->pPrivate->sThemeIcon = g_settings_get_string (self->pPrivate->pHighContrastSettings, "icon-theme");
-    }
+        const FeatureInfo *pInfo = &m_lFeatures[nFeature];
+        Intent *pIntent = &self->pPrivate->lIntents[nFeature];
+        gboolean bActive = pProfile->lFeatures[nFeature];
 
-    bThemeGtk = g_str_equal (self->pPrivate->sThemeGtk, "ContrastHigh");
-    bThemeIcon = g_str_equal (self->pPrivate->sThemeIcon, "ContrastHigh");
-    gboolean bHighContrast = (bThemeGtk && bThemeIcon);
+        if (!pIntent->pAction || !g_action_get_enabled (G_ACTION (pIntent->pAction)))
+        {
+            continue;
+        }
 
-    if (self->pPrivate->bHighContrast != bHighContrast)
-    {
-        GAction *pAction = g_action_map_lookup_action (G_ACTION_MAP (self->pPrivate->pActionGroup), "contrast");
-        GVariant *pValue = g_variant_new_boolean (bHighContrast);
-        g_action_change_state (pAction, pValue);
+        if (pIntent->pSettings)
+        {
+            batchSet (pBatches, getSchema (self, pInfo), pInfo->sKey, g_variant_new_boolean (bActive));
+        }
+        else if (bActive == pIntent->bDesired)
+        {
+            continue;
+        }
+        else if (nFeature == FEATURE_CONTRAST && !pIntent->bInFlight && self->pPrivate->pBackend && backend_batch_contrast (self->pPrivate->pBackend, bActive, onBatchContrast, pBatches))
+        {
+            // The theme keys are committed with the rest below, the backend takes the echo for its own write
+            pIntent->bApplied = pIntent->bDesired = bActive;
+            g_simple_action_set_state (pIntent->pAction, g_variant_new_boolean (bActive));
+        }
+        else
+        {
+            g_simple_action_set_state (pIntent->pAction, g_variant_new_boolean (bActive));
+            intentRequest (self, pIntent, bActive);
+        }
     }
-}
-
-static gboolean valueFromVariant (GValue *pValue, GVariant *pVariant, gpointer pUserData)
-{
-    g_value_set_variant (pValue, pVariant);
 
-    return TRUE;
-}
+    GHashTableIter cIter;
+    GSettings *pSettings = NULL;
+    g_hash_table_iter_init (&cIter, pBatches);
 
-static GVariant* valueToVariant (const GValue *pValue, const GVariantType *pType, gpointer pUserData)
-{
-    GVariant *pVariant = g_value_dup_variant (pValue);
+    while (g_hash_table_iter_next (&cIter, NULL, (gpointer*) &pSettings))
+    {
+        g_settings_apply (pSettings);
+        stats_count (STATS_BACKEND_CALLS);
+    }
 
-    return pVariant;
+    g_hash_table_destroy (pBatches);
+    profileDone (self);
+    TRACE_LEAVE ("onProfile", "profile", nProfile);
 }
 
-static void indicator_a11y_service_init (IndicatorA11yService *self)
+static void loadBackends (IndicatorA11yService *self)
 {
-    self->pPrivate = indicator_a11y_service_get_instance_private (self);
-    const char *sUser = g_get_user_name();
-    self->pPrivate->bGreeter = g_str_equal (sUser, "lightdm");
+    if (self->pPrivate->bBackendsLoaded)
+    {
+        return;
+    }
 
-    self->pPrivate->bOnboardActive = FALSE;
-    self->pPrivate->bOrcaActive = FALSE;
-    self->pPrivate->sThemeGtk = NULL;
-    self->pPrivate->sThemeIcon = NULL;
-    self->pPrivate->bIgnoreSettings = FALSE;
+    self->pPrivate->bBackendsLoaded = TRUE;
+    TRACE_ENTER ("loadBackends", NULL, -1);
 
-    GSettingsSchemaSource *pSource = g_settings_schema_source_get_default ();
-    GSettingsSchema *pSchema = NULL;
+    if (self->pPrivate->nDescribeFilter)
+    {
+        g_dbus_connection_remove_filter (self->pPrivate->pConnection, self->pPrivate->nDescribeFilter);
+        self->pPrivate->nDescribeFilter = 0;
+    }
 
     if (!self->pPrivate->bGreeter)
     {
-        // Get the settings
-        if (pSource)
+        // Switches backed by a settings key share one source per schema
+        for (guint nFeature = 0; nFeature < FEATURES; nFeature++)
         {
-            pSchema = g_settings_schema_source_lookup (pSource, "org.gnome.desktop.a11y.applications", FALSE);
+            const FeatureInfo *pInfo = &m_lFeatures[nFeature];
+            Intent *pIntent = &self->pPrivate->lIntents[nFeature];
 
-            if (pSchema)
-            {
-                g_settings_schema_unref (pSchema);
-                self->pPrivate->pOrcaSettings = g_settings_new ("org.gnome.desktop.a11y.applications");
-            }
-            else
+            if (!pInfo->sSchema)
             {
-                g_error ("Panic: No org.gnome.desktop.a11y.applications schema found");
+                continue;
             }
 
-            /* This is what we should use, but not all applications react to "high-contrast" setting (yet)
-            pSchema = g_settings_schema_source_lookup (pSource, "org.gnome.desktop.a11y.interface", FALSE);
+            const gchar *sSchema = getSchema (self, pInfo);
+            SettingsSource *pSource = getSettingsSource (self, sSchema, pInfo->sKey);
 
-            if (pSchema)
+            if (!pSource)
             {
-                g_settings_schema_unref (pSchema);
-                self->pPrivate->pHighContrastSettings = g_settings_new ("org.gnome.desktop.a11y.interface");
-                self->pPrivate->bHighContrast = g_settings_get_boolean (self->pPrivate->pHighContrastSettings, "high-contrast");
+                g_warning ("No %s key in %s found, disabling %s", pInfo->sKey, sSchema, pInfo->sAction);
+                g_simple_action_set_enabled (pIntent->pAction, FALSE);
+
+                continue;
             }
-            else
-            {
-                g_error ("Panic: No org.gnome.desktop.a11y.interface schema found");
-            }*/
 
-            pSchema = g_settings_schema_source_lookup (pSource, "org.mate.interface", FALSE);
+            pIntent->pSettings = pSource->pSettings;
+            g_hash_table_insert (pSource->pKeys, (gpointer) pInfo->sKey, pIntent);
+            intentSync (self, pIntent, g_settings_get_boolean (pSource->pSettings, pInfo->sKey));
+        }
+
+        const gchar *sThemeGtk = self->pPrivate->cSnapshot.sThemeGtk;
+        const gchar *sThemeIcon = self->pPrivate->cSnapshot.sThemeIcon;
+        self->pPrivate->pBackend = backend_new (self->pPrivate->eBackend, self->pPrivate->pConnection, sThemeGtk, sThemeIcon, onBackendChanged, onBackendApplied, self);
+
+        if (self->pPrivate->pBackend)
+        {
+            gboolean bActive = FALSE;
 
-            if (pSchema)
+            if (backend_get_contrast (self->pPrivate->pBackend, &bActive))
             {
-                g_settings_schema_unref (pSchema);
-                self->pPrivate->pHighContrastSettings = g_settings_new ("org.mate.interface");
-                self->pPrivate->sThemeGtk = g_settings_get_string (self->pPrivate->pHighContrastSettings, "gtk-theme");
-                self->pPrivate->sThemeIcon = g_settings_get_string (self->pPrivate->pHighContrastSettings, "icon-theme");
-                gboolean bThemeGtk = g_str_equal (self->pPrivate->sThemeGtk, "ContrastHigh");
-                gboolean bThemeIcon = g_str_equal (self->pPrivate->sThemeIcon, "ContrastHigh");
-                self->pPrivate->bHighContrast = (bThemeGtk && bThemeIcon);
+                intentSync (self, &self->pPrivate->lIntents[FEATURE_CONTRAST], bActive);
             }
-            else
+        }
+        else
+        {
+            g_warning ("The %s backend is not available, disabling high contrast", backend_get_name (self->pPrivate->eBackend));
+            g_simple_action_set_enabled (self->pPrivate->lIntents[FEATURE_CONTRAST].pAction, FALSE);
+        }
+
+        for (guint nSlider = 0; nSlider < SLIDERS; nSlider++)
+        {
+            Slider *pSlider = &self->pPrivate->lSliders[nSlider];
+            const SliderInfo *pInfo = &m_lSliders[nSlider];
+            pSlider->pSettings = backend_new_settings (pInfo->sSchema, pInfo->sKey);
+
+            if (!pSlider->pSettings)
             {
-                g_error ("Panic: No org.mate.interface schema found");
+                g_warning ("No %s schema found, disabling %s", pInfo->sSchema, pInfo->sAction);
+
+                continue;
             }
+
+            pSlider->pThrottle = throttle_new (pSlider->pSettings, pInfo->sKey, SLIDER_RATE);
+            GVariant *pValue = g_settings_get_value (pSlider->pSettings, pInfo->sKey);
+            g_simple_action_set_state (pSlider->pAction, pValue);
+            g_variant_unref (pValue);
+            g_simple_action_set_enabled (pSlider->pAction, TRUE);
+
+            gchar *sSignal = g_strconcat ("changed::", pInfo->sKey, NULL);
+            g_signal_connect (pSlider->pSettings, sSignal, G_CALLBACK (onSliderSettings), pSlider);
+            g_free (sSignal);
         }
     }
-    else
+
+    g_debug ("backends loaded after %" G_GINT64_FORMAT " us", g_get_monotonic_time () - self->pPrivate->nStartTime);
+    TRACE_LEAVE ("loadBackends", NULL, -1);
+}
+
+static void indicator_a11y_service_init (IndicatorA11yService *self)
+{
+    self->pPrivate = indicator_a11y_service_get_instance_private (self);
+    self->pPrivate->nStartTime = g_get_monotonic_time ();
+    self->pPrivate->nProfile = -1;
+    TRACE_ENTER ("init", NULL, -1);
+
+    // Show every helper until the probe tells us otherwise
+    self->pPrivate->nInstalled = (1 << FEATURES) - 1;
+
+    // Request the bus name first, the connection is set up while we build the menu
+    self->pPrivate->nOwnId = g_bus_own_name (G_BUS_TYPE_SESSION, BUS_NAME, G_BUS_NAME_OWNER_FLAGS_ALLOW_REPLACEMENT, onBusAcquired, onNameAcquired, onNameLost, self, NULL);
+
+    self->pPrivate->eBackend = backend_detect ();
+    self->pPrivate->bGreeter = (self->pPrivate->eBackend == BACKEND_GREETER);
+
+    // Trust the last snapshot until the backends are loaded
+    gboolean bSnapshot = snapshot_load (&self->pPrivate->cSnapshot);
+    self->pPrivate->bOnboardHint = bSnapshot && !self->pPrivate->bGreeter && (self->pPrivate->cSnapshot.nFlags & SNAPSHOT_ONBOARD_AVAILABLE);
+
+    for (guint nFeature = 0; nFeature < FEATURES; nFeature++)
     {
-        // Get Arctica settings
-        if (pSource)
-        {
-            pSchema = g_settings_schema_source_lookup (pSource, "org.ArcticaProject.arctica-greeter", FALSE);
+        Intent *pIntent = &self->pPrivate->lIntents[nFeature];
+        pIntent->pService = self;
+        pIntent->eFeature = nFeature;
+        pIntent->pApply = m_lFeatures[nFeature].pApply;
 
-            if (pSchema)
-            {
-                g_settings_schema_unref (pSchema);
-                self->pPrivate->pHighContrastSettings = g_settings_new ("org.ArcticaProject.arctica-greeter");
-                self->pPrivate->bHighContrast = g_settings_get_boolean (self->pPrivate->pHighContrastSettings, "high-contrast");
-            }
-            else
-            {
-                g_error ("Panic: No org.ArcticaProject.arctica-greeter schema found");
-            }
+        if (bSnapshot)
+        {
+            pIntent->bApplied = pIntent->bDesired = (self->pPrivate->cSnapshot.nFlags & m_lFeatures[nFeature].nSnapshotFlag) != 0;
         }
     }
 
+    self->pPrivate->pCancellable = g_cancellable_new ();
+    self->pPrivate->pOnboardProperties = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_variant_unref);
+
     // Create actions
     GSimpleAction *pAction = NULL;
     self->pPrivate->pActionGroup = g_simple_action_group_new ();
 
-    pAction = g_simple_action_new_stateful ("_header-desktop", NULL, createHeaderState (self));
+    self->pPrivate->lHeaders[FALSE] = createHeaderState (FALSE);
+    self->pPrivate->lHeaders[TRUE] = createHeaderState (TRUE);
+    pAction = g_simple_action_new_stateful ("_header-desktop", NULL, self->pPrivate->lHeaders[FALSE]);
     g_action_map_add_action (G_ACTION_MAP (self->pPrivate->pActionGroup), G_ACTION (pAction));
     self->pPrivate->pHeaderAction = pAction;
 
-    GVariant *pContrast = g_variant_new_boolean (self->pPrivate->bHighContrast);
-    pAction = g_simple_action_new_stateful ("contrast", G_VARIANT_TYPE_BOOLEAN, pContrast);
-
-    if (!self->pPrivate->bGreeter)
+    for (guint nFeature = 0; nFeature < FEATURES; nFeature++)
     {
-        /* This is what we should use, but not all applications react to "high-contrast" setting (yet)
-        g_settings_bind_with_mapping (self->pPrivate->pHighContrastSettings, "high-contrast", pAction, "state", G_SETTINGS_BIND_DEFAULT, valueFromVariant, valueToVariant, NULL, NULL);*/
+        const FeatureInfo *pInfo = &m_lFeatures[nFeature];
+
+        // The greeter cannot drive these, isAvailable () keeps their rows out of the menu so they need no action
+        if (self->pPrivate->bGreeter && !pInfo->bGreeter)
+        {
+            continue;
+        }
 
+        Intent *pIntent = &self->pPrivate->lIntents[nFeature];
+        pAction = g_simple_action_new_stateful (pInfo->sAction, G_VARIANT_TYPE_BOOLEAN, g_variant_new_boolean (pIntent->bApplied));
+        pIntent->pAction = pAction;
         g_action_map_add_action (G_ACTION_MAP (self->pPrivate->pActionGroup), G_ACTION (pAction));
+        g_signal_connect (pAction, "change-state", G_CALLBACK (onFeatureState), pIntent);
+        g_signal_connect (pAction, "notify::state", G_CALLBACK (onActionState), self);
+
+        // The greeter turned these calls down last time, wait for it to come back
+        if (self->pPrivate->bGreeter && bSnapshot && !(self->pPrivate->cSnapshot.nFlags & SNAPSHOT_GREETER_AVAILABLE))
+        {
+            g_simple_action_set_enabled (pAction, FALSE);
+        }
 
-        // Workaround for applications that do not react to "high-contrast" setting
-        g_signal_connect (pAction, "change-state", G_CALLBACK (onContrastState), self);
-        g_signal_connect (self->pPrivate->pHighContrastSettings, "changed::gtk-theme", G_CALLBACK (onContrastSettings), self);
-        g_signal_connect (self->pPrivate->pHighContrastSettings, "changed::icon-theme", G_CALLBACK (onContrastSettings), self);
+        g_object_unref (G_OBJECT (pAction));
     }
 
-    g_object_unref (G_OBJECT (pAction));
+    updateHeader (self);
 
-    GVariant *pOnboard = g_variant_new_boolean (self->pPrivate->bOnboardActive);
-    pAction = g_simple_action_new_stateful ("onboard", G_VARIANT_TYPE_BOOLEAN, pOnboard);
+    pAction = g_simple_action_new ("profile", G_VARIANT_TYPE_STRING);
     g_action_map_add_action (G_ACTION_MAP (self->pPrivate->pActionGroup), G_ACTION (pAction));
-    g_signal_connect (pAction, "change-state", G_CALLBACK (onOnboardState), self);
+    g_signal_connect (pAction, "activate", G_CALLBACK (onProfile), self);
     g_object_unref (G_OBJECT (pAction));
 
-    GVariant *pOrca = g_variant_new_boolean (self->pPrivate->bOrcaActive);
-    pAction = g_simple_action_new_stateful ("orca", G_VARIANT_TYPE_BOOLEAN, pOrca);
-    g_settings_bind_with_mapping (self->pPrivate->pOrcaSettings, "screen-reader-enabled", pAction, "state", G_SETTINGS_BIND_DEFAULT, valueFromVariant, valueToVariant, NULL, NULL);
-    g_action_map_add_action (G_ACTION_MAP (self->pPrivate->pActionGroup), G_ACTION (pAction));
-    g_signal_connect (pAction, "change-state", G_CALLBACK (onOrcaState), self);
-    g_object_unref (G_OBJECT (pAction));
+    // Sliders stay disabled until their settings are loaded
+    for (guint nSlider = 0; nSlider < SLIDERS && !self->pPrivate->bGreeter; nSlider++)
+    {
+        Slider *pSlider = &self->pPrivate->lSliders[nSlider];
+        pSlider->pService = self;
+        pSlider->eSlider = nSlider;
+        pAction = g_simple_action_new_stateful (m_lSliders[nSlider].sAction, G_VARIANT_TYPE_DOUBLE, g_variant_new_double (1.0));
+        g_simple_action_set_enabled (pAction, FALSE);
+        pSlider->pAction = pAction;
+        g_action_map_add_action (G_ACTION_MAP (self->pPrivate->pActionGroup), G_ACTION (pAction));
+        g_signal_connect (pAction, "change-state", G_CALLBACK (onSliderState), pSlider);
+        g_object_unref (G_OBJECT (pAction));
+    }
 
     // Add sections to the submenu
     self->pPrivate->pSubmenu = g_menu_new();
     GMenu *pSection = g_menu_new();
     GMenuItem *pItem = NULL;
 
-    pItem = g_menu_item_new (_("High Contrast"), "indicator.contrast");
-    g_menu_item_set_attribute (pItem, "x-ayatana-type", "s", "org.ayatana.indicator.switch");
-    g_menu_append_item (pSection, pItem);
-    g_object_unref (pItem);
-
-    pItem = g_menu_item_new (_("On-Screen Keyboard"), "indicator.onboard");
-    g_menu_item_set_attribute (pItem, "x-ayatana-type", "s", "org.ayatana.indicator.switch");
-    g_menu_append_item (pSection, pItem);
-    g_object_unref (pItem);
+    // The switches come and go with their helpers, the section is owned by the submenu
+    self->pPrivate->pSection = pSection;
+    updateSection (self);
 
-    pItem = g_menu_item_new (_("Screen Reader"), "indicator.orca");
-    g_menu_item_set_attribute (pItem, "x-ayatana-type", "s", "org.ayatana.indicator.switch");
-    g_menu_append_item (pSection, pItem);
-    g_object_unref (pItem);
+    for (guint nSlider = 0; nSlider < SLIDERS && !self->pPrivate->bGreeter; nSlider++)
+    {
+        const SliderInfo *pInfo = &m_lSliders[nSlider];
+        gchar *sAction = g_strconcat ("indicator.", pInfo->sAction, NULL);
+        pItem = g_menu_item_new (_(pInfo->sLabel), sAction);
+        g_menu_item_set_attribute (pItem, "x-ayatana-type", "s", "org.ayatana.indicator.slider");
+        g_menu_item_set_attribute (pItem, "min-value", "d", pInfo->fMin);
+        g_menu_item_set_attribute (pItem, "max-value", "d", pInfo->fMax);
+        g_menu_item_set_attribute (pItem, "step", "d", pInfo->fStep);
+        g_menu_item_set_attribute (pItem, "digits", "y", pInfo->nDigits);
+        g_menu_append_item (pSection, pItem);
+        g_object_unref (pItem);
+        g_free (sAction);
+    }
 
     g_menu_append_section (self->pPrivate->pSubmenu, NULL, G_MENU_MODEL (pSection));
     g_object_unref (pSection);
 
+    pSection = g_menu_new ();
+
+    for (guint nProfile = 0; nProfile < G_N_ELEMENTS (m_lProfiles); nProfile++)
+    {
+        pItem = g_menu_item_new (_(m_lProfiles[nProfile].sLabel), NULL);
+        g_menu_item_set_action_and_target_value (pItem, "indicator.profile", g_variant_new_string (m_lProfiles[nProfile].sName));
+        g_menu_append_item (pSection, pItem);
+        g_object_unref (pItem);
+    }
+
+    g_menu_append_section (self->pPrivate->pSubmenu, _("Profiles"), G_MENU_MODEL (pSection));
+    g_object_unref (pSection);
+
     // Add submenu to the header
     pItem = g_menu_item_new (NULL, "indicator._header-desktop");
     g_menu_item_set_attribute (pItem, "x-ayatana-type", "s", "org.ayatana.indicator.root");
@@ -518,7 +1680,13 @@ static void indicator_a11y_service_init (IndicatorA11yService *self)
     g_object_unref (pItem);
 
     self->pPrivate->bMenusBuilt = TRUE;
-    self->pPrivate->nOwnId = g_bus_own_name (G_BUS_TYPE_SESSION, BUS_NAME, G_BUS_NAME_OWNER_FLAGS_ALLOW_REPLACEMENT, onBusAcquired, NULL, onNameLost, self, NULL);
+    g_debug ("menus built after %" G_GINT64_FORMAT " us", g_get_monotonic_time () - self->pPrivate->nStartTime);
+
+    // Look for the helper programs off the main thread
+    GTask *pTask = g_task_new (self, self->pPrivate->pCancellable, onHelpersProbed, NULL);
+    g_task_run_in_thread (pTask, onProbeHelpers);
+    g_object_unref (pTask);
+    TRACE_LEAVE ("init", NULL, -1);
 }
 
 static void indicator_a11y_service_class_init (IndicatorA11yServiceClass *klass)
@@ -526,6 +1694,7 @@ static void indicator_a11y_service_class_init (IndicatorA11yServiceClass *klass)
     GObjectClass *pClass = G_OBJECT_CLASS(klass);
     pClass->dispose = onDispose;
     m_nSignal = g_signal_new ("name-lost", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (IndicatorA11yServiceClass, pNameLost), NULL, NULL, g_cclosure_marshal_VOID__VOID, G_TYPE_NONE, 0);
+    m_nIdleSignal = g_signal_new ("idle", G_TYPE_FROM_CLASS (klass), G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (IndicatorA11yServiceClass, pIdle), NULL, NULL, g_cclosure_marshal_VOID__VOID, G_TYPE_NONE, 0);
 }
 
 IndicatorA11yService *indicator_a11y_service_new ()
@@ -534,3 +1703,19 @@ IndicatorA11yService *indicator_a11y_service_new ()
 
     return INDICATOR_A11Y_SERVICE (pObject);
 }
+
+void indicator_a11y_service_set_idle_timeout (IndicatorA11yService *self, guint nTimeout)
+{
+    // Only takes effect when set before the bus is acquired
+    self->pPrivate->nIdleTimeout = nTimeout;
+}
+
+void indicator_a11y_service_set_reacquire (IndicatorA11yService *self, gboolean bReacquire)
+{
+    self->pPrivate->bReacquire = bReacquire;
+}
+
+GActionGroup* indicator_a11y_service_get_action_group (IndicatorA11yService *self)
+{
+    return G_ACTION_GROUP (self->pPrivate->pActionGroup);
+}
@@ -19,6 +19,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -40,10 +41,14 @@ struct _IndicatorA11yServiceClass
 {
     GObjectClass parent_class;
     void (*pNameLost)(IndicatorA11yService *self);
+    void (*pIdle)(IndicatorA11yService *self);
 };
 
 GType indicator_a11y_service_get_type(void);
 IndicatorA11yService* indicator_a11y_service_new();
+void indicator_a11y_service_set_idle_timeout (IndicatorA11yService *self, guint nTimeout);
+void indicator_a11y_service_set_reacquire (IndicatorA11yService *self, gboolean bReacquire);
+GActionGroup* indicator_a11y_service_get_action_group (IndicatorA11yService *self);
 
 G_END_DECLS
 
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+#include "snapshot.h"
+
+#define SNAPSHOT_MAGIC 0x59313141
+#define SNAPSHOT_VERSION 1
+
+// On-disk layout: the header is followed by the two theme names, each NUL-terminated
+typedef struct
+{
+    guint32 nMagic;
+    guint32 nVersion;
+    guint32 nFlags;
+    guint16 nThemeGtk;
+    guint16 nThemeIcon;
+} SnapshotHeader;
+
+static gchar* getPath ()
+{
+    return g_build_filename (g_get_user_runtime_dir (), "ayatana-indicator-a11y.state", NULL);
+}
+
+static gchar* readString (const gchar *sData, gsize nLength)
+{
+    // Zero length means not set
+    if (!nLength || sData[nLength - 1] != '\0')
+    {
+        return NULL;
+    }
+
+    return g_strndup (sData, nLength - 1);
+}
+
+gboolean snapshot_load (Snapshot *pSnapshot)
+{
+    memset (pSnapshot, 0, sizeof (Snapshot));
+
+    gchar *sPath = getPath ();
+    GMappedFile *pFile = g_mapped_file_new (sPath, FALSE, NULL);
+    g_free (sPath);
+
+    if (!pFile)
+    {
+        return FALSE;
+    }
+
+    gboolean bValid = FALSE;
+    gsize nLength = g_mapped_file_get_length (pFile);
+    const gchar *sData = g_mapped_file_get_contents (pFile);
+
+    if (nLength >= sizeof (SnapshotHeader))
+    {
+        SnapshotHeader cHeader;
+        memcpy (&cHeader, sData, sizeof (SnapshotHeader));
+
+        if (cHeader.nMagic == SNAPSHOT_MAGIC && cHeader.nVersion == SNAPSHOT_VERSION && nLength == sizeof (SnapshotHeader) + cHeader.nThemeGtk + cHeader.nThemeIcon)
+        {
+            sData += sizeof (SnapshotHeader);
+            pSnapshot->nFlags = cHeader.nFlags;
+            pSnapshot->sThemeGtk = readString (sData, cHeader.nThemeGtk);
+            pSnapshot->sThemeIcon = readString (sData + cHeader.nThemeGtk, cHeader.nThemeIcon);
+            bValid = TRUE;
+        }
+    }
+
+    if (!bValid)
+    {
+        g_warning ("Ignoring invalid or outdated state snapshot");
+    }
+
+    g_mapped_file_unref (pFile);
+
+    return bValid;
+}
+
+gboolean snapshot_save (const Snapshot *pSnapshot)
+{
+    SnapshotHeader cHeader = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, pSnapshot->nFlags, 0, 0};
+
+    if (pSnapshot->sThemeGtk)
+    {
+        cHeader.nThemeGtk = strlen (pSnapshot->sThemeGtk) + 1;
+    }
+
+    if (pSnapshot->sThemeIcon)
+    {
+        cHeader.nThemeIcon = strlen (pSnapshot->sThemeIcon) + 1;
+    }
+
+    GByteArray *pData = g_byte_array_sized_new (sizeof (SnapshotHeader) + cHeader.nThemeGtk + cHeader.nThemeIcon);
+    g_byte_array_append (pData, (const guint8*) &cHeader, sizeof (SnapshotHeader));
+    g_byte_array_append (pData, (const guint8*) pSnapshot->sThemeGtk, cHeader.nThemeGtk);
+    g_byte_array_append (pData, (const guint8*) pSnapshot->sThemeIcon, cHeader.nThemeIcon);
+
+    GError *pError = NULL;
+    gchar *sPath = getPath ();
+    gboolean bSaved = g_file_set_contents (sPath, (const gchar*) pData->data, pData->len, &pError);
+
+    if (!bSaved)
+    {
+        g_warning ("Failed to save state snapshot: %s", pError->message);
+        g_error_free (pError);
+    }
+
+    g_free (sPath);
+    g_byte_array_unref (pData);
+
+    return bSaved;
+}
+
+void snapshot_clear (Snapshot *pSnapshot)
+{
+    g_clear_pointer (&pSnapshot->sThemeGtk, g_free);
+    g_clear_pointer (&pSnapshot->sThemeIcon, g_free);
+}
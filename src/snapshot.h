@@ -0,0 +1,48 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __INDICATOR_A11Y_SNAPSHOT_H__
+#define __INDICATOR_A11Y_SNAPSHOT_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define SNAPSHOT_CONTRAST (1 << 0)
+#define SNAPSHOT_ONBOARD (1 << 1)
+#define SNAPSHOT_ORCA (1 << 2)
+#define SNAPSHOT_ONBOARD_AVAILABLE (1 << 3)
+#define SNAPSHOT_GREETER_AVAILABLE (1 << 4)
+#define SNAPSHOT_STICKY_KEYS (1 << 5)
+#define SNAPSHOT_SLOW_KEYS (1 << 6)
+#define SNAPSHOT_BOUNCE_KEYS (1 << 7)
+#define SNAPSHOT_MOUSE_KEYS (1 << 8)
+
+typedef struct
+{
+    guint32 nFlags;
+    gchar *sThemeGtk;
+    gchar *sThemeIcon;
+} Snapshot;
+
+gboolean snapshot_load (Snapshot *pSnapshot);
+gboolean snapshot_save (const Snapshot *pSnapshot);
+void snapshot_clear (Snapshot *pSnapshot);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "stats.h"
+
+static guint64 m_lCounters[STATS_COUNTERS] = {0};
+static guint64 m_lHistograms[STATS_LATENCIES][STATS_BUCKETS] = {{0}};
+
+static const gchar *m_lCounterNames[STATS_COUNTERS] = {"onboard-signals", "settings-notifications", "echoes-suppressed", "backend-calls", "writes-dropped"};
+static const gchar *m_lLatencyNames[STATS_LATENCIES] = {"onboard", "greeter", "settings", "main-loop-stalls", "profiles"};
+
+static const gchar m_sIntrospection[] =
+    "<node>"
+    "  <interface name='org.ayatana.indicator.a11y.Stats'>"
+    "    <method name='GetCounters'>"
+    "      <arg type='a{st}' name='counters' direction='out'/>"
+    "    </method>"
+    "    <method name='GetHistograms'>"
+    "      <arg type='a{sat}' name='histograms' direction='out'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+static void onMethodCall (GDBusConnection *pConnection, const gchar *sSender, const gchar *sPath, const gchar *sInterface, const gchar *sMethod, GVariant *pParameters, GDBusMethodInvocation *pInvocation, gpointer pUserData)
+{
+    GVariantBuilder cBuilder;
+
+    if (g_str_equal (sMethod, "GetCounters"))
+    {
+        g_variant_builder_init (&cBuilder, G_VARIANT_TYPE ("a{st}"));
+
+        for (guint nCounter = 0; nCounter < STATS_COUNTERS; nCounter++)
+        {
+            g_variant_builder_add (&cBuilder, "{st}", m_lCounterNames[nCounter], m_lCounters[nCounter]);
+        }
+
+        g_dbus_method_invocation_return_value (pInvocation, g_variant_new ("(a{st})", &cBuilder));
+    }
+    else if (g_str_equal (sMethod, "GetHistograms"))
+    {
+        g_variant_builder_init (&cBuilder, G_VARIANT_TYPE ("a{sat}"));
+
+        for (guint nLatency = 0; nLatency < STATS_LATENCIES; nLatency++)
+        {
+            GVariant *pBuckets = g_variant_new_fixed_array (G_VARIANT_TYPE_UINT64, m_lHistograms[nLatency], STATS_BUCKETS, sizeof (guint64));
+            g_variant_builder_add (&cBuilder, "{s@at}", m_lLatencyNames[nLatency], pBuckets);
+        }
+
+        g_dbus_method_invocation_return_value (pInvocation, g_variant_new ("(a{sat})", &cBuilder));
+    }
+}
+
+static const GDBusInterfaceVTable m_cVTable = {onMethodCall, NULL, NULL};
+
+void stats_count (StatsCounter eCounter)
+{
+    m_lCounters[eCounter]++;
+}
+
+guint64 stats_get_count (StatsCounter eCounter)
+{
+    return m_lCounters[eCounter];
+}
+
+void stats_latency (StatsLatency eLatency, gint64 nMicroseconds)
+{
+    // Fixed buckets, nothing is allocated on the hot path
+    guint nBucket = MIN (g_bit_storage (MAX (nMicroseconds, 0)), STATS_BUCKETS - 1);
+    m_lHistograms[eLatency][nBucket]++;
+}
+
+guint stats_export (GDBusConnection *pConnection, const gchar *sPath, GError **pError)
+{
+    GDBusNodeInfo *pInfo = g_dbus_node_info_new_for_xml (m_sIntrospection, pError);
+
+    if (!pInfo)
+    {
+        return 0;
+    }
+
+    guint nId = g_dbus_connection_register_object (pConnection, sPath, pInfo->interfaces[0], &m_cVTable, NULL, NULL, pError);
+    g_dbus_node_info_unref (pInfo);
+
+    return nId;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __INDICATOR_A11Y_STATS_H__
+#define __INDICATOR_A11Y_STATS_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    STATS_ONBOARD_SIGNALS,
+    STATS_SETTINGS_NOTIFICATIONS,
+    STATS_ECHOES_SUPPRESSED,
+    STATS_BACKEND_CALLS,
+    STATS_WRITES_DROPPED,
+    STATS_COUNTERS
+} StatsCounter;
+
+typedef enum
+{
+    STATS_LATENCY_ONBOARD,
+    STATS_LATENCY_GREETER,
+    STATS_LATENCY_SETTINGS,
+    STATS_LATENCY_STALL,
+    STATS_LATENCY_PROFILE,
+    STATS_LATENCIES
+} StatsLatency;
+
+// Bucket n counts latencies up to 2^n microseconds, the last one everything above
+#define STATS_BUCKETS 24
+
+void stats_count (StatsCounter eCounter);
+guint64 stats_get_count (StatsCounter eCounter);
+void stats_latency (StatsLatency eLatency, gint64 nMicroseconds);
+guint stats_export (GDBusConnection *pConnection, const gchar *sPath, GError **pError);
+
+G_END_DECLS
+
+#endif
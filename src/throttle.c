@@ -0,0 +1,149 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "throttle.h"
+#include "stats.h"
+#include "trace.h"
+
+struct _Throttle
+{
+    GSettings *pSettings;
+    gchar *sKey;
+    gint64 nInterval;
+    gint64 nLast;
+    GVariant *pPending;
+    GVariant *pWritten;
+    guint nTimeout;
+    guint nDropped;
+};
+
+static void writeValue (Throttle *pThrottle, GVariant *pValue)
+{
+    gint64 nStart = g_get_monotonic_time ();
+
+    // Known before the write, the changed signal for it may be emitted from within
+    g_clear_pointer (&pThrottle->pWritten, g_variant_unref);
+    pThrottle->pWritten = g_variant_ref (pValue);
+    g_settings_set_value (pThrottle->pSettings, pThrottle->sKey, pValue);
+    pThrottle->nLast = g_get_monotonic_time ();
+    stats_count (STATS_BACKEND_CALLS);
+    stats_latency (STATS_LATENCY_SETTINGS, pThrottle->nLast - nStart);
+}
+
+static gboolean onTimeout (gpointer pData)
+{
+    TRACE_ENTER ("onThrottleTimeout", NULL, -1);
+
+    Throttle *pThrottle = pData;
+    pThrottle->nTimeout = 0;
+
+    // The last value always gets written
+    if (pThrottle->pPending)
+    {
+        writeValue (pThrottle, pThrottle->pPending);
+        g_clear_pointer (&pThrottle->pPending, g_variant_unref);
+    }
+
+    if (pThrottle->nDropped)
+    {
+        g_debug ("%s: %u writes dropped", pThrottle->sKey, pThrottle->nDropped);
+        pThrottle->nDropped = 0;
+    }
+
+    TRACE_LEAVE ("onThrottleTimeout", NULL, -1);
+
+    return G_SOURCE_REMOVE;
+}
+
+Throttle* throttle_new (GSettings *pSettings, const gchar *sKey, guint nRate)
+{
+    Throttle *pThrottle = g_new0 (Throttle, 1);
+    pThrottle->pSettings = g_object_ref (pSettings);
+    pThrottle->sKey = g_strdup (sKey);
+    pThrottle->nInterval = G_USEC_PER_SEC / MAX (nRate, 1);
+
+    return pThrottle;
+}
+
+void throttle_free (Throttle *pThrottle)
+{
+    // Do not lose the value the user let go at
+    if (pThrottle->nTimeout)
+    {
+        g_source_remove (pThrottle->nTimeout);
+        onTimeout (pThrottle);
+    }
+
+    g_clear_pointer (&pThrottle->pWritten, g_variant_unref);
+    g_object_unref (pThrottle->pSettings);
+    g_free (pThrottle->sKey);
+    g_free (pThrottle);
+}
+
+void throttle_write (Throttle *pThrottle, GVariant *pValue)
+{
+    g_variant_ref_sink (pValue);
+
+    if (pThrottle->nTimeout)
+    {
+        // A write is already scheduled, it will take the newest value
+        if (pThrottle->pPending)
+        {
+            g_variant_unref (pThrottle->pPending);
+            pThrottle->nDropped++;
+            stats_count (STATS_WRITES_DROPPED);
+        }
+
+        pThrottle->pPending = pValue;
+
+        return;
+    }
+
+    gint64 nWait = pThrottle->nLast + pThrottle->nInterval - g_get_monotonic_time ();
+
+    if (nWait <= 0)
+    {
+        writeValue (pThrottle, pValue);
+        g_variant_unref (pValue);
+
+        // Writes within the next interval are held back
+        pThrottle->nTimeout = g_timeout_add (pThrottle->nInterval / 1000, onTimeout, pThrottle);
+    }
+    else
+    {
+        pThrottle->pPending = pValue;
+        pThrottle->nTimeout = g_timeout_add (nWait / 1000 + 1, onTimeout, pThrottle);
+    }
+}
+
+void throttle_cancel (Throttle *pThrottle)
+{
+    // Someone else writes the key, drop what is held back
+    if (pThrottle->nTimeout)
+    {
+        g_source_remove (pThrottle->nTimeout);
+        pThrottle->nTimeout = 0;
+    }
+
+    g_clear_pointer (&pThrottle->pPending, g_variant_unref);
+    g_clear_pointer (&pThrottle->pWritten, g_variant_unref);
+}
+
+gboolean throttle_is_echo (Throttle *pThrottle, GVariant *pValue)
+{
+    return pThrottle->pWritten && g_variant_equal (pThrottle->pWritten, pValue);
+}
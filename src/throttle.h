@@ -0,0 +1,35 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __INDICATOR_A11Y_THROTTLE_H__
+#define __INDICATOR_A11Y_THROTTLE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _Throttle Throttle;
+
+Throttle* throttle_new (GSettings *pSettings, const gchar *sKey, guint nRate);
+void throttle_free (Throttle *pThrottle);
+void throttle_write (Throttle *pThrottle, GVariant *pValue);
+void throttle_cancel (Throttle *pThrottle);
+gboolean throttle_is_echo (Throttle *pThrottle, GVariant *pValue);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "trace.h"
+
+#ifdef ENABLE_TRACING
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#endif
+
+#ifdef HAVE_SYSPROF
+#include <sysprof-capture.h>
+
+static gint64 m_lStart[8] = {0};
+static gint m_lRequested[8] = {0};
+static guint m_nDepth = 0;
+#endif
+
+void trace_enter (const gchar *sHandler, const gchar *sAction, gint nRequested)
+{
+    watchdog_enter (sHandler);
+
+#ifdef HAVE_SYS_SDT_H
+    // A no-op instruction unless a tracer attaches to it
+    DTRACE_PROBE3 (ayatana_indicator_a11y, handler_enter, sHandler, sAction, nRequested);
+#endif
+
+#ifdef HAVE_SYSPROF
+    if (m_nDepth < G_N_ELEMENTS (m_lStart))
+    {
+        m_lStart[m_nDepth] = sysprof_collector_is_active () ? SYSPROF_CAPTURE_CURRENT_TIME : 0;
+        m_lRequested[m_nDepth] = nRequested;
+    }
+
+    m_nDepth++;
+#endif
+}
+
+void trace_leave (const gchar *sHandler, const gchar *sAction, gint nResult)
+{
+#ifdef HAVE_SYS_SDT_H
+    DTRACE_PROBE3 (ayatana_indicator_a11y, handler_leave, sHandler, sAction, nResult);
+#endif
+
+#ifdef HAVE_SYSPROF
+    if (m_nDepth)
+    {
+        m_nDepth--;
+
+        if (m_nDepth < G_N_ELEMENTS (m_lStart) && m_lStart[m_nDepth])
+        {
+            gint64 nStart = m_lStart[m_nDepth];
+            sysprof_collector_mark_printf (nStart, SYSPROF_CAPTURE_CURRENT_TIME - nStart, "a11y", sHandler, "%s: requested %d, result %d", sAction ? sAction : "-", m_lRequested[m_nDepth], nResult);
+        }
+    }
+#endif
+
+    watchdog_leave ();
+}
+
+#endif
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __INDICATOR_A11Y_TRACE_H__
+#define __INDICATOR_A11Y_TRACE_H__
+
+#include <glib.h>
+#include "watchdog.h"
+
+G_BEGIN_DECLS
+
+// States are passed as 0/1, -1 when not applicable
+#ifdef ENABLE_TRACING
+void trace_enter (const gchar *sHandler, const gchar *sAction, gint nRequested);
+void trace_leave (const gchar *sHandler, const gchar *sAction, gint nResult);
+#define TRACE_ENTER(sHandler, sAction, nRequested) trace_enter (sHandler, sAction, nRequested)
+#define TRACE_LEAVE(sHandler, sAction, nResult) trace_leave (sHandler, sAction, nResult)
+#else
+#define TRACE_ENTER(sHandler, sAction, nRequested) watchdog_enter (sHandler)
+#define TRACE_LEAVE(sHandler, sAction, nResult) watchdog_leave ()
+#endif
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "watchdog.h"
+#include "stats.h"
+
+static GPollFunc m_pPoll = NULL;
+static gint64 m_nThreshold = 0;
+static gint64 m_nWake = 0;
+static const gchar *m_sHandler = NULL;
+static const gchar *m_sLastHandler = NULL;
+static gint64 m_nHandlerStart = 0;
+static guint m_nDepth = 0;
+static gboolean m_bReported = FALSE;
+
+static gint onPoll (GPollFD *lFds, guint nFds, gint nTimeout)
+{
+    // Everything between waking up and polling again is one dispatch round
+    if (m_nWake)
+    {
+        gint64 nDuration = g_get_monotonic_time () - m_nWake;
+
+        if (nDuration > m_nThreshold)
+        {
+            stats_latency (STATS_LATENCY_STALL, nDuration);
+
+            if (!m_bReported)
+            {
+                g_warning ("Main loop stalled for %" G_GINT64_FORMAT " ms, last handler: %s", nDuration / 1000, m_sLastHandler ? m_sLastHandler : "unknown");
+            }
+        }
+    }
+
+    gint nRet = m_pPoll (lFds, nFds, nTimeout);
+    m_nWake = g_get_monotonic_time ();
+    m_sLastHandler = NULL;
+    m_bReported = FALSE;
+
+    return nRet;
+}
+
+void watchdog_start (GMainContext *pContext, gint64 nThreshold)
+{
+    if (m_pPoll)
+    {
+        return;
+    }
+
+    m_nThreshold = nThreshold;
+    m_pPoll = g_main_context_get_poll_func (pContext);
+    g_main_context_set_poll_func (pContext, onPoll);
+}
+
+void watchdog_enter (const gchar *sHandler)
+{
+    // Nested handlers are accounted to the outermost one
+    if (!m_pPoll || m_nDepth++)
+    {
+        return;
+    }
+
+    m_sHandler = sHandler;
+    m_nHandlerStart = g_get_monotonic_time ();
+}
+
+void watchdog_leave ()
+{
+    if (!m_pPoll || !m_nDepth || --m_nDepth)
+    {
+        return;
+    }
+
+    gint64 nDuration = g_get_monotonic_time () - m_nHandlerStart;
+
+    if (nDuration > m_nThreshold)
+    {
+        g_warning ("%s blocked the main loop for %" G_GINT64_FORMAT " ms", m_sHandler, nDuration / 1000);
+        m_bReported = TRUE;
+    }
+
+    m_sLastHandler = m_sHandler;
+    m_sHandler = NULL;
+}
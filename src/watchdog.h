@@ -0,0 +1,31 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __INDICATOR_A11Y_WATCHDOG_H__
+#define __INDICATOR_A11Y_WATCHDOG_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void watchdog_start (GMainContext *pContext, gint64 nThreshold);
+void watchdog_enter (const gchar *sHandler);
+void watchdog_leave ();
+
+G_END_DECLS
+
+#endif
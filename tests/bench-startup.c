@@ -0,0 +1,119 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <signal.h>
+#include "harness.h"
+
+#define RUNS 50
+
+// Subscribe to the desktop menu the way a panel does, retrying until it is exported
+static gboolean startMenu (Harness *pHarness, gint64 nDeadline)
+{
+    GDBusConnection *pConnection = harness_get_client_connection (pHarness);
+    guint lGroups[] = {0};
+
+    while (g_get_monotonic_time () < nDeadline)
+    {
+        GVariant *pGroups = g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32, lGroups, G_N_ELEMENTS (lGroups), sizeof (guint));
+        GVariant *pReply = g_dbus_connection_call_sync (pConnection, HARNESS_BUS_NAME, HARNESS_BUS_PATH "/desktop", "org.gtk.Menus", "Start", g_variant_new_tuple (&pGroups, 1), NULL, G_DBUS_CALL_FLAGS_NONE, HARNESS_TIMEOUT, NULL, NULL);
+
+        if (pReply)
+        {
+            g_variant_unref (pReply);
+
+            return TRUE;
+        }
+
+        harness_iterate (pHarness, 1);
+    }
+
+    return FALSE;
+}
+
+// Time from exec to the bus name and to the first successful menu subscription
+static gboolean benchRun (Harness *pHarness, const gchar *sService, GArray *pNamed, GArray *pExported)
+{
+    GError *pError = NULL;
+    gint64 nStart = g_get_monotonic_time ();
+    GSubprocess *pProcess = g_subprocess_new (G_SUBPROCESS_FLAGS_NONE, &pError, sService, NULL);
+
+    if (!pProcess)
+    {
+        g_printerr ("Cannot start %s: %s\n", sService, pError->message);
+        g_error_free (pError);
+
+        return FALSE;
+    }
+
+    gboolean bPassed = harness_wait_name (pHarness, TRUE, HARNESS_TIMEOUT);
+
+    if (bPassed)
+    {
+        gint64 nNamed = g_get_monotonic_time () - nStart;
+        g_array_append_val (pNamed, nNamed);
+        bPassed = startMenu (pHarness, nStart + HARNESS_TIMEOUT * 1000);
+    }
+
+    if (bPassed)
+    {
+        gint64 nExported = g_get_monotonic_time () - nStart;
+        g_array_append_val (pExported, nExported);
+    }
+    else
+    {
+        g_printerr ("The service did not come up within %d ms\n", HARNESS_TIMEOUT);
+    }
+
+    g_subprocess_send_signal (pProcess, SIGINT);
+    g_subprocess_wait (pProcess, NULL, NULL);
+    g_object_unref (pProcess);
+
+    // The next run must not find the previous owner still on the bus
+    return harness_wait_name (pHarness, FALSE, HARNESS_TIMEOUT) && bPassed;
+}
+
+int main (int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        g_printerr ("Usage: %s SERVICE [BACKEND] [RUNS]\n", argv[0]);
+
+        return 2;
+    }
+
+    const gchar *sService = argv[1];
+    const gchar *sBackend = argc > 2 ? argv[2] : "GNOME";
+    guint nRuns = argc > 3 ? (guint) g_ascii_strtoull (argv[3], NULL, 10) : RUNS;
+    GArray *pNamed = g_array_sized_new (FALSE, FALSE, sizeof (gint64), nRuns);
+    GArray *pExported = g_array_sized_new (FALSE, FALSE, sizeof (gint64), nRuns);
+    gboolean bPassed = TRUE;
+
+    Harness *pHarness = harness_new (sBackend, FALSE);
+    g_print ("Startup latency, %s backend, %u runs\n", sBackend, nRuns);
+
+    for (guint nRun = 0; nRun < nRuns && bPassed; nRun++)
+    {
+        bPassed = benchRun (pHarness, sService, pNamed, pExported);
+    }
+
+    harness_report ("name acquired", pNamed);
+    harness_report ("menu exported", pExported);
+    g_array_unref (pNamed);
+    g_array_unref (pExported);
+    harness_free (pHarness);
+
+    return bPassed ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "harness.h"
+
+#define ITERATIONS 200
+
+// Time from SetState on the exported action group to the backend call and to the state-change signal
+static gboolean benchAction (Harness *pHarness, const gchar *sAction, guint nIterations)
+{
+    GArray *pBackend = g_array_sized_new (FALSE, FALSE, sizeof (gint64), nIterations);
+    GArray *pState = g_array_sized_new (FALSE, FALSE, sizeof (gint64), nIterations);
+    gboolean bActive = FALSE;
+    gboolean bPassed = TRUE;
+
+    // The first round loads the backends and is not counted
+    for (guint nIteration = 0; nIteration <= nIterations; nIteration++)
+    {
+        bActive = !bActive;
+        harness_reset (pHarness);
+
+        gint64 nStart = g_get_monotonic_time ();
+        harness_set_state (pHarness, sAction, g_variant_new_boolean (bActive));
+
+        if (!harness_wait_action (pHarness, sAction, HARNESS_TIMEOUT))
+        {
+            g_printerr ("%s: no backend call or state change after %d ms\n", sAction, HARNESS_TIMEOUT);
+            bPassed = FALSE;
+
+            break;
+        }
+
+        if (nIteration)
+        {
+            HarnessAction *pAction = harness_get_action (pHarness, sAction);
+            gint64 nBackend = pAction->nBackendTime - nStart;
+            gint64 nState = pAction->nStateTime - nStart;
+            g_array_append_val (pBackend, nBackend);
+            g_array_append_val (pState, nState);
+        }
+
+        // Let the echoes of this round settle before the next one
+        harness_iterate (pHarness, 5);
+    }
+
+    gchar *sLabel = g_strdup_printf ("%s backend call", sAction);
+    harness_report (sLabel, pBackend);
+    g_free (sLabel);
+    sLabel = g_strdup_printf ("%s state signal", sAction);
+    harness_report (sLabel, pState);
+    g_free (sLabel);
+
+    g_array_unref (pBackend);
+    g_array_unref (pState);
+
+    return bPassed;
+}
+
+int main (int argc, char **argv)
+{
+    const gchar *sBackend = argc > 1 ? argv[1] : "GNOME";
+    guint nIterations = argc > 2 ? (guint) g_ascii_strtoull (argv[2], NULL, 10) : ITERATIONS;
+    gboolean bGreeter = !g_ascii_strcasecmp (sBackend, "greeter");
+    const gchar *lDesktop[] = {"contrast", "onboard", "orca", NULL};
+    const gchar *lGreeter[] = {"onboard", "orca", NULL};
+    const gchar **lActions = bGreeter ? lGreeter : lDesktop;
+    gboolean bPassed = TRUE;
+
+    Harness *pHarness = harness_new (sBackend, TRUE);
+    g_print ("Toggle latency, %s backend, %u iterations\n", sBackend, nIterations);
+
+    for (guint nAction = 0; lActions[nAction]; nAction++)
+    {
+        bPassed = benchAction (pHarness, lActions[nAction], nIterations) && bPassed;
+    }
+
+    harness_free (pHarness);
+
+    return bPassed ? 0 : 1;
+}
@@ -0,0 +1,522 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sys/resource.h>
+#include <time.h>
+#include <glib/gstdio.h>
+#include "service.h"
+#include "harness.h"
+
+#define ONBOARD_NAME "org.onboard.Onboard"
+#define ONBOARD_PATH "/org/onboard/Onboard/Keyboard"
+#define ONBOARD_INTERFACE "org.onboard.Onboard.Keyboard"
+#define GREETER_NAME "org.ArcticaProject.ArcticaGreeter"
+#define GREETER_PATH "/org/ArcticaProject/ArcticaGreeter"
+
+struct _Harness
+{
+    GTestDBus *pBus;
+    gchar *sRuntimeDir;
+    GDBusConnection *pClient;
+    GDBusConnection *pMock;
+    guint nOnboardObject;
+    guint nGreeterObject;
+    guint nOnboardName;
+    guint nGreeterName;
+    guint nMockNames;
+    gboolean bOnboardVisible;
+    guint nChangedSubscription;
+    guint nNameWatch;
+    gboolean bNameOwned;
+    GHashTable *pActions;
+    GHashTable *pSettings;
+    IndicatorA11yService *pService;
+};
+
+// The keys the service writes, and the action each one belongs to
+typedef struct
+{
+    const gchar *sSchema;
+    const gchar *sKey;
+    const gchar *sAction;
+} HarnessKey;
+
+static const HarnessKey m_lKeys[] =
+{
+    {"org.gnome.desktop.a11y.interface", "high-contrast", "contrast"},
+    {"org.mate.interface", "gtk-theme", "contrast"},
+    {"org.gnome.desktop.a11y.applications", "screen-reader-enabled", "orca"},
+    {"org.gnome.desktop.a11y.magnifier", "mag-factor", "magnifier"},
+    {"org.gnome.desktop.interface", "text-scaling-factor", "text-scaling"},
+    {"org.gnome.desktop.a11y.keyboard", "stickykeys-enable", "sticky-keys"},
+    {"org.gnome.desktop.a11y.keyboard", "slowkeys-enable", "slow-keys"},
+    {"org.gnome.desktop.a11y.keyboard", "bouncekeys-enable", "bounce-keys"},
+    {"org.gnome.desktop.a11y.keyboard", "mousekeys-enable", "mouse-keys"},
+    {"org.mate.accessibility-keyboard", "stickykeys-enable", "sticky-keys"},
+    {"org.mate.accessibility-keyboard", "slowkeys-enable", "slow-keys"},
+    {"org.mate.accessibility-keyboard", "bouncekeys-enable", "bounce-keys"},
+    {"org.mate.accessibility-keyboard", "mousekeys-enable", "mouse-keys"}
+};
+
+static const gchar m_sOnboardXml[] =
+    "<node>"
+    "  <interface name='org.onboard.Onboard.Keyboard'>"
+    "    <method name='Show'/>"
+    "    <method name='Hide'/>"
+    "    <method name='ToggleVisible'/>"
+    "    <property name='Visible' type='b' access='read'/>"
+    "  </interface>"
+    "</node>";
+
+static const gchar m_sGreeterXml[] =
+    "<node>"
+    "  <interface name='org.ArcticaProject.ArcticaGreeter'>"
+    "    <method name='ToggleOnBoard'>"
+    "      <arg type='b' name='active' direction='in'/>"
+    "    </method>"
+    "    <method name='ToggleOrca'>"
+    "      <arg type='b' name='active' direction='in'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+static void onBackendCall (Harness *pHarness, const gchar *sAction)
+{
+    HarnessAction *pAction = harness_get_action (pHarness, sAction);
+
+    if (!pAction->nBackendTime)
+    {
+        pAction->nBackendTime = g_get_monotonic_time ();
+    }
+
+    pAction->nBackendCalls++;
+}
+
+static void emitOnboardVisible (Harness *pHarness)
+{
+    GVariantBuilder cBuilder;
+    g_variant_builder_init (&cBuilder, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (&cBuilder, "{sv}", "Visible", g_variant_new_boolean (pHarness->bOnboardVisible));
+    harness_onboard_emit (pHarness, g_variant_new ("(sa{sv}as)", ONBOARD_INTERFACE, &cBuilder, NULL));
+}
+
+static void onOnboardMethod (GDBusConnection *pConnection, const gchar *sSender, const gchar *sPath, const gchar *sInterface, const gchar *sMethod, GVariant *pParameters, GDBusMethodInvocation *pInvocation, gpointer pUserData)
+{
+    Harness *pHarness = pUserData;
+    onBackendCall (pHarness, "onboard");
+
+    if (g_str_equal (sMethod, "Show"))
+    {
+        pHarness->bOnboardVisible = TRUE;
+    }
+    else if (g_str_equal (sMethod, "Hide"))
+    {
+        pHarness->bOnboardVisible = FALSE;
+    }
+    else
+    {
+        pHarness->bOnboardVisible = !pHarness->bOnboardVisible;
+    }
+
+    g_dbus_method_invocation_return_value (pInvocation, NULL);
+    emitOnboardVisible (pHarness);
+}
+
+static GVariant* onOnboardProperty (GDBusConnection *pConnection, const gchar *sSender, const gchar *sPath, const gchar *sInterface, const gchar *sProperty, GError **pError, gpointer pUserData)
+{
+    Harness *pHarness = pUserData;
+
+    return g_variant_new_boolean (pHarness->bOnboardVisible);
+}
+
+static void onGreeterMethod (GDBusConnection *pConnection, const gchar *sSender, const gchar *sPath, const gchar *sInterface, const gchar *sMethod, GVariant *pParameters, GDBusMethodInvocation *pInvocation, gpointer pUserData)
+{
+    Harness *pHarness = pUserData;
+
+    if (g_str_equal (sMethod, "ToggleOnBoard"))
+    {
+        onBackendCall (pHarness, "onboard");
+    }
+    else
+    {
+        onBackendCall (pHarness, "orca");
+    }
+
+    g_dbus_method_invocation_return_value (pInvocation, NULL);
+}
+
+static const GDBusInterfaceVTable m_cOnboardVTable = {onOnboardMethod, onOnboardProperty, NULL};
+static const GDBusInterfaceVTable m_cGreeterVTable = {onGreeterMethod, NULL, NULL};
+
+static guint registerMock (Harness *pHarness, const gchar *sPath, const gchar *sXml, const GDBusInterfaceVTable *pVTable)
+{
+    GError *pError = NULL;
+    GDBusNodeInfo *pInfo = g_dbus_node_info_new_for_xml (sXml, &pError);
+    g_assert_no_error (pError);
+
+    guint nId = g_dbus_connection_register_object (pHarness->pMock, sPath, pInfo->interfaces[0], pVTable, pHarness, NULL, &pError);
+    g_assert_no_error (pError);
+    g_dbus_node_info_unref (pInfo);
+
+    return nId;
+}
+
+static void onMockName (GDBusConnection *pConnection, const gchar *sName, gpointer pUserData)
+{
+    Harness *pHarness = pUserData;
+    pHarness->nMockNames++;
+}
+
+static void onChanged (GDBusConnection *pConnection, const gchar *sSender, const gchar *sPath, const gchar *sInterface, const gchar *sSignal, GVariant *pParameters, gpointer pUserData)
+{
+    Harness *pHarness = pUserData;
+    gint64 nNow = g_get_monotonic_time ();
+    GVariant *pStates = g_variant_get_child_value (pParameters, 2);
+    GVariantIter cIter;
+    const gchar *sAction = NULL;
+    GVariant *pValue = NULL;
+    g_variant_iter_init (&cIter, pStates);
+
+    while (g_variant_iter_next (&cIter, "{&sv}", &sAction, &pValue))
+    {
+        HarnessAction *pAction = harness_get_action (pHarness, sAction);
+
+        if (!pAction->nStateTime)
+        {
+            pAction->nStateTime = nNow;
+        }
+
+        pAction->nStateChanges++;
+        g_variant_unref (pValue);
+    }
+
+    g_variant_unref (pStates);
+}
+
+static void onActionStateChanged (GActionGroup *pActionGroup, const gchar *sAction, GVariant *pValue, gpointer pUserData)
+{
+    Harness *pHarness = pUserData;
+    harness_get_action (pHarness, sAction)->nStateEmissions++;
+}
+
+static void onSettings (GSettings *pSettings, const gchar *sKey, gpointer pUserData)
+{
+    Harness *pHarness = pUserData;
+    gchar *sSchema = NULL;
+    g_object_get (pSettings, "schema-id", &sSchema, NULL);
+
+    for (guint nKey = 0; nKey < G_N_ELEMENTS (m_lKeys); nKey++)
+    {
+        if (g_str_equal (m_lKeys[nKey].sSchema, sSchema) && g_str_equal (m_lKeys[nKey].sKey, sKey))
+        {
+            onBackendCall (pHarness, m_lKeys[nKey].sAction);
+        }
+    }
+
+    g_free (sSchema);
+}
+
+static void onNameAppeared (GDBusConnection *pConnection, const gchar *sName, const gchar *sOwner, gpointer pUserData)
+{
+    Harness *pHarness = pUserData;
+    pHarness->bNameOwned = TRUE;
+}
+
+static void onNameVanished (GDBusConnection *pConnection, const gchar *sName, gpointer pUserData)
+{
+    Harness *pHarness = pUserData;
+    pHarness->bNameOwned = FALSE;
+}
+
+static GDBusConnection* connectBus (Harness *pHarness)
+{
+    GError *pError = NULL;
+    GDBusConnection *pConnection = g_dbus_connection_new_for_address_sync (g_test_dbus_get_bus_address (pHarness->pBus), G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION, NULL, NULL, &pError);
+    g_assert_no_error (pError);
+
+    return pConnection;
+}
+
+static gboolean onTimeout (gpointer pData)
+{
+    gboolean *pExpired = pData;
+    *pExpired = TRUE;
+
+    return G_SOURCE_REMOVE;
+}
+
+Harness* harness_new (const gchar *sBackend, gboolean bService)
+{
+    Harness *pHarness = g_new0 (Harness, 1);
+
+    // Nothing may reach the real desktop: settings live in memory, state files in a scratch directory
+    pHarness->sRuntimeDir = g_dir_make_tmp ("ayatana-indicator-a11y-XXXXXX", NULL);
+    g_assert_nonnull (pHarness->sRuntimeDir);
+    g_setenv ("XDG_RUNTIME_DIR", pHarness->sRuntimeDir, TRUE);
+    g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+    g_setenv ("GSETTINGS_SCHEMA_DIR", HARNESS_SCHEMA_DIR, TRUE);
+    g_setenv ("AYATANA_A11Y_BACKEND", sBackend, TRUE);
+
+    pHarness->pBus = g_test_dbus_new (G_TEST_DBUS_NONE);
+    g_test_dbus_up (pHarness->pBus);
+    pHarness->pClient = connectBus (pHarness);
+    pHarness->pMock = connectBus (pHarness);
+    pHarness->pActions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    pHarness->pSettings = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+
+    for (guint nKey = 0; nKey < G_N_ELEMENTS (m_lKeys); nKey++)
+    {
+        if (!g_hash_table_contains (pHarness->pSettings, m_lKeys[nKey].sSchema))
+        {
+            GSettings *pSettings = g_settings_new (m_lKeys[nKey].sSchema);
+            g_signal_connect (pSettings, "changed", G_CALLBACK (onSettings), pHarness);
+            g_hash_table_insert (pHarness->pSettings, (gpointer) m_lKeys[nKey].sSchema, pSettings);
+        }
+    }
+
+    pHarness->nOnboardObject = registerMock (pHarness, ONBOARD_PATH, m_sOnboardXml, &m_cOnboardVTable);
+    pHarness->nGreeterObject = registerMock (pHarness, GREETER_PATH, m_sGreeterXml, &m_cGreeterVTable);
+    pHarness->nOnboardName = g_bus_own_name_on_connection (pHarness->pMock, ONBOARD_NAME, G_BUS_NAME_OWNER_FLAGS_NONE, onMockName, NULL, pHarness, NULL);
+    pHarness->nGreeterName = g_bus_own_name_on_connection (pHarness->pMock, GREETER_NAME, G_BUS_NAME_OWNER_FLAGS_NONE, onMockName, NULL, pHarness, NULL);
+    pHarness->nChangedSubscription = g_dbus_connection_signal_subscribe (pHarness->pClient, NULL, "org.gtk.Actions", "Changed", HARNESS_BUS_PATH, NULL, G_DBUS_SIGNAL_FLAGS_NONE, onChanged, pHarness, NULL);
+    pHarness->nNameWatch = g_bus_watch_name_on_connection (pHarness->pClient, HARNESS_BUS_NAME, G_BUS_NAME_WATCHER_FLAGS_NONE, onNameAppeared, onNameVanished, pHarness, NULL);
+
+    while (pHarness->nMockNames < 2)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    if (bService)
+    {
+        pHarness->pService = indicator_a11y_service_new ();
+        g_signal_connect (indicator_a11y_service_get_action_group (pHarness->pService), "action-state-changed", G_CALLBACK (onActionStateChanged), pHarness);
+
+        if (!harness_wait_name (pHarness, TRUE, HARNESS_TIMEOUT))
+        {
+            g_error ("The service did not acquire %s", HARNESS_BUS_NAME);
+        }
+    }
+
+    return pHarness;
+}
+
+void harness_free (Harness *pHarness)
+{
+    // Let the service drop every reference to the session bus before it goes down
+    g_clear_object (&pHarness->pService);
+    harness_iterate (pHarness, 100);
+
+    g_bus_unwatch_name (pHarness->nNameWatch);
+    g_dbus_connection_signal_unsubscribe (pHarness->pClient, pHarness->nChangedSubscription);
+    g_bus_unown_name (pHarness->nOnboardName);
+    g_bus_unown_name (pHarness->nGreeterName);
+    g_dbus_connection_unregister_object (pHarness->pMock, pHarness->nOnboardObject);
+    g_dbus_connection_unregister_object (pHarness->pMock, pHarness->nGreeterObject);
+    g_hash_table_destroy (pHarness->pSettings);
+    g_hash_table_destroy (pHarness->pActions);
+    g_dbus_connection_close_sync (pHarness->pClient, NULL, NULL);
+    g_dbus_connection_close_sync (pHarness->pMock, NULL, NULL);
+    g_clear_object (&pHarness->pClient);
+    g_clear_object (&pHarness->pMock);
+    harness_iterate (pHarness, 10);
+
+    g_test_dbus_down (pHarness->pBus);
+    g_clear_object (&pHarness->pBus);
+
+    gchar *sSnapshot = g_build_filename (pHarness->sRuntimeDir, "ayatana-indicator-a11y.state", NULL);
+    g_unlink (sSnapshot);
+    g_free (sSnapshot);
+    g_rmdir (pHarness->sRuntimeDir);
+    g_free (pHarness->sRuntimeDir);
+    g_free (pHarness);
+}
+
+GObject* harness_get_service (Harness *pHarness)
+{
+    return G_OBJECT (pHarness->pService);
+}
+
+GDBusConnection* harness_get_client_connection (Harness *pHarness)
+{
+    return pHarness->pClient;
+}
+
+GDBusConnection* harness_get_mock_connection (Harness *pHarness)
+{
+    return pHarness->pMock;
+}
+
+HarnessAction* harness_get_action (Harness *pHarness, const gchar *sAction)
+{
+    HarnessAction *pAction = g_hash_table_lookup (pHarness->pActions, sAction);
+
+    if (!pAction)
+    {
+        pAction = g_new0 (HarnessAction, 1);
+        g_hash_table_insert (pHarness->pActions, g_strdup (sAction), pAction);
+    }
+
+    return pAction;
+}
+
+void harness_reset (Harness *pHarness)
+{
+    g_hash_table_remove_all (pHarness->pActions);
+}
+
+void harness_set_state (Harness *pHarness, const gchar *sAction, GVariant *pValue)
+{
+    g_dbus_connection_call (pHarness->pClient, HARNESS_BUS_NAME, HARNESS_BUS_PATH, "org.gtk.Actions", "SetState", g_variant_new ("(sva{sv})", sAction, pValue, NULL), NULL, G_DBUS_CALL_FLAGS_NONE, HARNESS_TIMEOUT, NULL, NULL, NULL);
+}
+
+void harness_activate (Harness *pHarness, const gchar *sAction, GVariant *pParameter)
+{
+    GVariantBuilder cBuilder;
+    g_variant_builder_init (&cBuilder, G_VARIANT_TYPE ("av"));
+
+    if (pParameter)
+    {
+        g_variant_builder_add (&cBuilder, "v", pParameter);
+    }
+
+    g_dbus_connection_call (pHarness->pClient, HARNESS_BUS_NAME, HARNESS_BUS_PATH, "org.gtk.Actions", "Activate", g_variant_new ("(sava{sv})", sAction, &cBuilder, NULL), NULL, G_DBUS_CALL_FLAGS_NONE, HARNESS_TIMEOUT, NULL, NULL, NULL);
+}
+
+void harness_set_setting (Harness *pHarness, const gchar *sSchema, const gchar *sKey, GVariant *pValue)
+{
+    GSettings *pSettings = g_hash_table_lookup (pHarness->pSettings, sSchema);
+
+    if (pSettings)
+    {
+        g_settings_set_value (pSettings, sKey, pValue);
+    }
+    else
+    {
+        g_variant_unref (g_variant_ref_sink (pValue));
+        g_warning ("The harness has no %s schema", sSchema);
+    }
+}
+
+void harness_onboard_emit (Harness *pHarness, GVariant *pParameters)
+{
+    g_dbus_connection_emit_signal (pHarness->pMock, NULL, ONBOARD_PATH, "org.freedesktop.DBus.Properties", "PropertiesChanged", pParameters, NULL);
+}
+
+void harness_onboard_set_visible (Harness *pHarness, gboolean bVisible)
+{
+    pHarness->bOnboardVisible = bVisible;
+    emitOnboardVisible (pHarness);
+}
+
+gboolean harness_wait_action (Harness *pHarness, const gchar *sAction, guint nTimeout)
+{
+    gboolean bExpired = FALSE;
+    guint nSource = g_timeout_add (nTimeout, onTimeout, &bExpired);
+    HarnessAction *pAction = harness_get_action (pHarness, sAction);
+
+    while (!bExpired && (!pAction->nBackendTime || !pAction->nStateTime))
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    if (!bExpired)
+    {
+        g_source_remove (nSource);
+    }
+
+    return !bExpired;
+}
+
+gboolean harness_wait_name (Harness *pHarness, gboolean bOwned, guint nTimeout)
+{
+    gboolean bExpired = FALSE;
+    guint nSource = g_timeout_add (nTimeout, onTimeout, &bExpired);
+
+    while (!bExpired && pHarness->bNameOwned != bOwned)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    if (!bExpired)
+    {
+        g_source_remove (nSource);
+    }
+
+    return !bExpired;
+}
+
+void harness_iterate (Harness *pHarness, guint nTimeout)
+{
+    gboolean bExpired = FALSE;
+    g_timeout_add (nTimeout, onTimeout, &bExpired);
+
+    while (!bExpired)
+    {
+        g_main_context_iteration (NULL, TRUE);
+    }
+}
+
+static gint compareSamples (gconstpointer pA, gconstpointer pB)
+{
+    gint64 nA = *(const gint64*) pA;
+    gint64 nB = *(const gint64*) pB;
+
+    return (nA > nB) - (nA < nB);
+}
+
+void harness_report (const gchar *sLabel, GArray *pSamples)
+{
+    if (!pSamples->len)
+    {
+        g_print ("%-24s no samples\n", sLabel);
+
+        return;
+    }
+
+    g_array_sort (pSamples, compareSamples);
+
+    guint nLast = pSamples->len - 1;
+    gint64 nP50 = g_array_index (pSamples, gint64, nLast * 50 / 100);
+    gint64 nP90 = g_array_index (pSamples, gint64, nLast * 90 / 100);
+    gint64 nP99 = g_array_index (pSamples, gint64, nLast * 99 / 100);
+    gint64 nMax = g_array_index (pSamples, gint64, nLast);
+    g_print ("%-24s n=%-5u p50=%-8" G_GINT64_FORMAT " p90=%-8" G_GINT64_FORMAT " p99=%-8" G_GINT64_FORMAT " max=%-8" G_GINT64_FORMAT " us\n", sLabel, pSamples->len, nP50, nP90, nP99, nMax);
+}
+
+gint64 harness_get_cpu_time ()
+{
+    struct timespec cTime;
+    clock_gettime (CLOCK_THREAD_CPUTIME_ID, &cTime);
+
+    return cTime.tv_sec * G_USEC_PER_SEC + cTime.tv_nsec / 1000;
+}
+
+// User and system time of every thread, the GDBus worker included
+gint64 harness_get_process_cpu_time ()
+{
+    struct rusage cUsage;
+    getrusage (RUSAGE_SELF, &cUsage);
+
+    return (gint64) (cUsage.ru_utime.tv_sec + cUsage.ru_stime.tv_sec) * G_USEC_PER_SEC + cUsage.ru_utime.tv_usec + cUsage.ru_stime.tv_usec;
+}
+
+glong harness_get_peak_rss ()
+{
+    struct rusage cUsage;
+    getrusage (RUSAGE_SELF, &cUsage);
+
+    return cUsage.ru_maxrss;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __INDICATOR_A11Y_HARNESS_H__
+#define __INDICATOR_A11Y_HARNESS_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define HARNESS_BUS_NAME "org.ayatana.indicator.a11y"
+#define HARNESS_BUS_PATH "/org/ayatana/indicator/a11y"
+#define HARNESS_TIMEOUT 5000
+
+// What the harness saw happen to one action since the last reset, times are monotonic
+// nStateChanges counts the entries of the Changed signals on the bus, nStateEmissions the in-process action-state-changed emissions
+typedef struct
+{
+    gint64 nBackendTime;
+    gint64 nStateTime;
+    guint nBackendCalls;
+    guint nStateChanges;
+    guint nStateEmissions;
+} HarnessAction;
+
+typedef struct _Harness Harness;
+
+Harness* harness_new (const gchar *sBackend, gboolean bService);
+void harness_free (Harness *pHarness);
+GObject* harness_get_service (Harness *pHarness);
+GDBusConnection* harness_get_client_connection (Harness *pHarness);
+GDBusConnection* harness_get_mock_connection (Harness *pHarness);
+HarnessAction* harness_get_action (Harness *pHarness, const gchar *sAction);
+void harness_reset (Harness *pHarness);
+void harness_set_state (Harness *pHarness, const gchar *sAction, GVariant *pValue);
+void harness_activate (Harness *pHarness, const gchar *sAction, GVariant *pParameter);
+void harness_set_setting (Harness *pHarness, const gchar *sSchema, const gchar *sKey, GVariant *pValue);
+void harness_onboard_emit (Harness *pHarness, GVariant *pParameters);
+void harness_onboard_set_visible (Harness *pHarness, gboolean bVisible);
+gboolean harness_wait_action (Harness *pHarness, const gchar *sAction, guint nTimeout);
+gboolean harness_wait_name (Harness *pHarness, gboolean bOwned, guint nTimeout);
+void harness_iterate (Harness *pHarness, guint nTimeout);
+void harness_report (const gchar *sLabel, GArray *pSamples);
+gint64 harness_get_cpu_time ();
+gint64 harness_get_process_cpu_time ();
+glong harness_get_peak_rss ();
+
+G_END_DECLS
+
+#endif
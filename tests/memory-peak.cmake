@@ -0,0 +1,33 @@
+# Runs PROGRAM under massif and fails when its peak heap exceeds the number of bytes in BUDGET
+
+execute_process (COMMAND "${VALGRIND}" --tool=massif "--massif-out-file=${OUTPUT}" "${PROGRAM}" RESULT_VARIABLE RESULT)
+
+if (NOT RESULT EQUAL 0)
+    message (FATAL_ERROR "${PROGRAM} failed under massif: ${RESULT}")
+endif ()
+
+file (STRINGS "${OUTPUT}" SNAPSHOTS REGEX "^mem_heap_B=")
+set (PEAK 0)
+
+foreach (SNAPSHOT ${SNAPSHOTS})
+    string (REGEX REPLACE "^mem_heap_B=" "" HEAP "${SNAPSHOT}")
+
+    if (HEAP GREATER PEAK)
+        set (PEAK "${HEAP}")
+    endif ()
+endforeach ()
+
+# The budget is the measured peak plus 20% headroom
+math (EXPR SUGGESTED "${PEAK} * 6 / 5")
+file (STRINGS "${BUDGET}" LIMITS REGEX "^[0-9]+$")
+
+if (NOT LIMITS)
+    message (FATAL_ERROR "No budget in ${BUDGET}, the measured peak heap is ${PEAK} bytes: check in ${SUGGESTED}")
+endif ()
+
+list (GET LIMITS 0 LIMIT)
+message (STATUS "Peak heap: ${PEAK} bytes, budget: ${LIMIT} bytes")
+
+if (PEAK GREATER LIMIT)
+    message (FATAL_ERROR "Peak heap of ${PEAK} bytes is over the budget of ${LIMIT} bytes in ${BUDGET}, the peak plus headroom is ${SUGGESTED}")
+endif ()
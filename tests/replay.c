@@ -0,0 +1,367 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+#include "recorder.h"
+#include "service.h"
+#include "stats.h"
+#include "harness.h"
+
+#define ROUNDS 20
+
+// Where a recorded settings key lives, the keyboard keys depend on the backend
+typedef struct
+{
+    const gchar *sKey;
+    const gchar *sGnomeSchema;
+    const gchar *sMateSchema;
+} ReplayKey;
+
+static const ReplayKey m_lKeys[] =
+{
+    {"mag-factor", "org.gnome.desktop.a11y.magnifier", "org.gnome.desktop.a11y.magnifier"},
+    {"text-scaling-factor", "org.gnome.desktop.interface", "org.gnome.desktop.interface"},
+    {"screen-reader-enabled", "org.gnome.desktop.a11y.applications", "org.gnome.desktop.a11y.applications"},
+    {"stickykeys-enable", "org.gnome.desktop.a11y.keyboard", "org.mate.accessibility-keyboard"},
+    {"slowkeys-enable", "org.gnome.desktop.a11y.keyboard", "org.mate.accessibility-keyboard"},
+    {"bouncekeys-enable", "org.gnome.desktop.a11y.keyboard", "org.mate.accessibility-keyboard"},
+    {"mousekeys-enable", "org.gnome.desktop.a11y.keyboard", "org.mate.accessibility-keyboard"}
+};
+
+// Every event enters the service the way it was first received: from the bus, from the settings, or from a client
+static void replayDispatch (Harness *pHarness, gboolean bMate, RecorderEntry *pEntry)
+{
+    switch (pEntry->eEvent)
+    {
+        case RECORDER_ONBOARD:
+        {
+            if (pEntry->pValue && g_variant_is_of_type (pEntry->pValue, G_VARIANT_TYPE ("(sa{sv}as)")))
+            {
+                harness_onboard_emit (pHarness, pEntry->pValue);
+            }
+
+            break;
+        }
+        case RECORDER_SETTINGS:
+        {
+            for (guint nKey = 0; nKey < G_N_ELEMENTS (m_lKeys) && pEntry->pValue; nKey++)
+            {
+                if (g_str_equal (pEntry->sName, m_lKeys[nKey].sKey))
+                {
+                    harness_set_setting (pHarness, bMate ? m_lKeys[nKey].sMateSchema : m_lKeys[nKey].sGnomeSchema, pEntry->sName, pEntry->pValue);
+                }
+            }
+
+            break;
+        }
+        case RECORDER_BACKEND:
+        {
+            if (!pEntry->pValue || !g_variant_is_of_type (pEntry->pValue, G_VARIANT_TYPE_BOOLEAN))
+            {
+                break;
+            }
+
+            gboolean bActive = g_variant_get_boolean (pEntry->pValue);
+
+            // Change the theme the way the desktop's own settings panel would
+            if (bMate)
+            {
+                harness_set_setting (pHarness, "org.mate.interface", "gtk-theme", g_variant_new_string (bActive ? "ContrastHigh" : "Menta"));
+                harness_set_setting (pHarness, "org.mate.interface", "icon-theme", g_variant_new_string (bActive ? "ContrastHigh" : "menta"));
+            }
+            else
+            {
+                harness_set_setting (pHarness, "org.gnome.desktop.a11y.interface", "high-contrast", g_variant_new_boolean (bActive));
+            }
+
+            break;
+        }
+        case RECORDER_ACTIVATE:
+        {
+            harness_activate (pHarness, pEntry->sName, pEntry->pValue);
+
+            break;
+        }
+        case RECORDER_CHANGE_STATE:
+        {
+            if (pEntry->pValue)
+            {
+                harness_set_state (pHarness, pEntry->sName, pEntry->pValue);
+            }
+
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+// The state of every stateful action, read from the service's own action group
+static GHashTable* getStates (Harness *pHarness)
+{
+    GActionGroup *pActionGroup = indicator_a11y_service_get_action_group (INDICATOR_A11Y_SERVICE (harness_get_service (pHarness)));
+    GHashTable *pStates = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_variant_unref);
+    gchar **lActions = g_action_group_list_actions (pActionGroup);
+
+    for (guint nAction = 0; lActions[nAction]; nAction++)
+    {
+        GVariant *pState = g_action_group_get_action_state (pActionGroup, lActions[nAction]);
+
+        if (pState)
+        {
+            g_hash_table_insert (pStates, g_strdup (lActions[nAction]), pState);
+        }
+    }
+
+    g_strfreev (lActions);
+
+    return pStates;
+}
+
+// Reports every action that ended up somewhere else than in the recording
+static gboolean compareStates (GHashTable *pRecorded, GHashTable *pReplayed)
+{
+    GHashTableIter cIter;
+    const gchar *sAction = NULL;
+    GVariant *pRecordedState = NULL;
+    gboolean bEqual = TRUE;
+    g_hash_table_iter_init (&cIter, pRecorded);
+
+    while (g_hash_table_iter_next (&cIter, (gpointer*) &sAction, (gpointer*) &pRecordedState))
+    {
+        GVariant *pReplayedState = g_hash_table_lookup (pReplayed, sAction);
+
+        if (!pReplayedState || !g_variant_equal (pRecordedState, pReplayedState))
+        {
+            gchar *sRecorded = g_variant_print (pRecordedState, FALSE);
+            gchar *sReplayed = pReplayedState ? g_variant_print (pReplayedState, FALSE) : g_strdup ("nothing");
+            g_printerr ("%s ended as %s, the recording ended as %s\n", sAction, sReplayed, sRecorded);
+            g_free (sRecorded);
+            g_free (sReplayed);
+            bEqual = FALSE;
+        }
+    }
+
+    return bEqual;
+}
+
+// Feeds a recording to a fresh service, returns the number of events or -1, and optionally the final states and the backend calls made
+static gint replay (const gchar *sPath, const gchar *sBackend, gboolean bRealtime, GHashTable **pStates, guint64 *pCalls)
+{
+    GError *pError = NULL;
+    RecorderLog *pLog = recorder_log_open (sPath, &pError);
+
+    if (!pLog)
+    {
+        g_printerr ("%s\n", pError->message);
+        g_error_free (pError);
+
+        return -1;
+    }
+
+    Harness *pHarness = harness_new (sBackend, TRUE);
+    gboolean bMate = !g_ascii_strcasecmp (sBackend, "MATE");
+    RecorderEntry cEntry = {0, 0, NULL, NULL};
+    gint nEvents = 0;
+    guint64 nCalls = stats_get_count (STATS_BACKEND_CALLS);
+    gint64 nCpuTime = harness_get_cpu_time ();
+    gint64 nStart = g_get_monotonic_time ();
+
+    while (recorder_log_next (pLog, &cEntry))
+    {
+        gint64 nWait = nStart + cEntry.nTime - g_get_monotonic_time ();
+
+        if (bRealtime && nWait > 1000)
+        {
+            harness_iterate (pHarness, nWait / 1000);
+        }
+
+        replayDispatch (pHarness, bMate, &cEntry);
+        recorder_entry_clear (&cEntry);
+        nEvents++;
+
+        // Let the replies to this event come in before the next one
+        while (g_main_context_iteration (NULL, FALSE));
+    }
+
+    harness_iterate (pHarness, 200);
+    nCpuTime = harness_get_cpu_time () - nCpuTime;
+    nCalls = stats_get_count (STATS_BACKEND_CALLS) - nCalls;
+
+    // The service and the harness share the main thread, so this is the cost of the whole replay rather than of the handlers
+    g_print ("Replayed %d events on the %s backend in %" G_GINT64_FORMAT " us of main thread CPU time, service and harness together, making %" G_GUINT64_FORMAT " backend calls\n", nEvents, sBackend, nCpuTime, nCalls);
+
+    if (pStates)
+    {
+        *pStates = getStates (pHarness);
+    }
+
+    if (pCalls)
+    {
+        *pCalls = nCalls;
+    }
+
+    harness_free (pHarness);
+    recorder_log_free (pLog);
+
+    return nEvents;
+}
+
+// Drives the service through the harness with the recorder on, returns the number of events or -1 and the final states
+static gint record (const gchar *sPath, const gchar *sBackend, GHashTable **pStates)
+{
+    GError *pError = NULL;
+    Harness *pHarness = harness_new (sBackend, TRUE);
+
+    if (!recorder_start (sPath, &pError))
+    {
+        g_printerr ("%s\n", pError->message);
+        g_error_free (pError);
+        harness_free (pHarness);
+
+        return -1;
+    }
+
+    for (guint nRound = 0; nRound < ROUNDS; nRound++)
+    {
+        gboolean bActive = (nRound % 2 == 0);
+        harness_set_state (pHarness, "contrast", g_variant_new_boolean (bActive));
+        harness_set_state (pHarness, "onboard", g_variant_new_boolean (bActive));
+        harness_set_state (pHarness, "sticky-keys", g_variant_new_boolean (bActive));
+        harness_set_state (pHarness, "magnifier", g_variant_new_double (1.0 + nRound % 4));
+        harness_onboard_set_visible (pHarness, !bActive);
+        harness_set_setting (pHarness, "org.gnome.desktop.a11y.interface", "high-contrast", g_variant_new_boolean (!bActive));
+        harness_set_setting (pHarness, "org.gnome.desktop.interface", "text-scaling-factor", g_variant_new_double (1.0 + (nRound % 3) * 0.25));
+        harness_iterate (pHarness, 20);
+
+        if (nRound % 5 == 4)
+        {
+            harness_activate (pHarness, "profile", g_variant_new_string ("low-vision"));
+            harness_iterate (pHarness, 20);
+        }
+    }
+
+    recorder_stop ();
+    harness_iterate (pHarness, 200);
+    *pStates = getStates (pHarness);
+    harness_free (pHarness);
+
+    RecorderLog *pLog = recorder_log_open (sPath, &pError);
+
+    if (!pLog)
+    {
+        g_printerr ("%s\n", pError->message);
+        g_error_free (pError);
+
+        return -1;
+    }
+
+    RecorderEntry cEntry = {0, 0, NULL, NULL};
+    gint nEvents = 0;
+
+    while (recorder_log_next (pLog, &cEntry))
+    {
+        recorder_entry_clear (&cEntry);
+        nEvents++;
+    }
+
+    recorder_log_free (pLog);
+
+    return nEvents;
+}
+
+int main (int argc, char **argv)
+{
+    gchar *sBackend = NULL;
+    gboolean bFast = FALSE;
+    gchar **lFiles = NULL;
+    GOptionEntry lEntries[] =
+    {
+        {"backend", 0, 0, G_OPTION_ARG_STRING, &sBackend, "Replay against the NAME backend (default: GNOME)", "NAME"},
+        {"fast", 0, 0, G_OPTION_ARG_NONE, &bFast, "Replay as fast as possible instead of at the recorded speed", NULL},
+        {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &lFiles, NULL, "[FILE]"},
+        {NULL}
+    };
+
+    GError *pError = NULL;
+    GOptionContext *pContext = g_option_context_new (NULL);
+    g_option_context_set_summary (pContext, "Replays a recording made with --record on a private bus with mock services and in-memory settings.\nWithout a FILE, records a scripted workload first and replays that.");
+    g_option_context_add_main_entries (pContext, lEntries, NULL);
+
+    if (!g_option_context_parse (pContext, &argc, &argv, &pError))
+    {
+        g_printerr ("%s\n", pError->message);
+        g_error_free (pError);
+        g_option_context_free (pContext);
+
+        return 2;
+    }
+
+    g_option_context_free (pContext);
+
+    const gchar *sUseBackend = sBackend ? sBackend : "GNOME";
+    gboolean bPassed = FALSE;
+
+    if (lFiles && lFiles[0])
+    {
+        bPassed = replay (lFiles[0], sUseBackend, !bFast, NULL, NULL) >= 0;
+    }
+    else
+    {
+        gchar *sPath = NULL;
+        gint nHandle = g_file_open_tmp ("ayatana-indicator-a11y-XXXXXX.rec", &sPath, &pError);
+
+        if (nHandle < 0)
+        {
+            g_printerr ("%s\n", pError->message);
+            g_error_free (pError);
+        }
+        else
+        {
+            GHashTable *pRecorded = NULL;
+            GHashTable *pReplayed = NULL;
+            guint64 nCalls = 0;
+            g_close (nHandle, NULL);
+            gint nRecorded = record (sPath, sUseBackend, &pRecorded);
+            gint nReplayed = nRecorded > 0 ? replay (sPath, sUseBackend, !bFast, &pReplayed, &nCalls) : -1;
+            g_print ("Recorded %d events, replayed %d\n", nRecorded, nReplayed);
+
+            // The workload switches features from a client, so the replay has to reach the backends and end where the recording did
+            if (nRecorded > 0 && nReplayed == nRecorded)
+            {
+                bPassed = compareStates (pRecorded, pReplayed);
+
+                if (!nCalls)
+                {
+                    g_printerr ("The replay made no backend calls\n");
+                    bPassed = FALSE;
+                }
+            }
+
+            g_clear_pointer (&pRecorded, g_hash_table_destroy);
+            g_clear_pointer (&pReplayed, g_hash_table_destroy);
+            g_unlink (sPath);
+            g_free (sPath);
+        }
+    }
+
+    g_strfreev (lFiles);
+    g_free (sBackend);
+
+    return bPassed ? 0 : 1;
+}
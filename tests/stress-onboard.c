@@ -0,0 +1,158 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stats.h"
+#include "harness.h"
+
+#define RATE 40000
+#define SIGNALS 40000
+#define FLAT_FACTOR 3.0
+#define COALESCED_BURST 100
+
+typedef struct
+{
+    GDBusConnection *pConnection;
+    guint nBurst;
+    gint nDone;
+    gint64 nCpuTime;
+} Flood;
+
+// Emits SIGNALS PropertiesChanged signals in bursts of nBurst, paced to RATE per second on average
+static gpointer onFlood (gpointer pData)
+{
+    Flood *pFlood = pData;
+    gint64 nCpuTime = harness_get_cpu_time ();
+    gint64 nStart = g_get_monotonic_time ();
+    gboolean bVisible = FALSE;
+
+    for (guint nSent = 0; nSent < SIGNALS;)
+    {
+        for (guint nSignal = 0; nSignal < pFlood->nBurst && nSent < SIGNALS; nSignal++, nSent++)
+        {
+            GVariantBuilder cBuilder;
+            bVisible = !bVisible;
+            g_variant_builder_init (&cBuilder, G_VARIANT_TYPE ("a{sv}"));
+            g_variant_builder_add (&cBuilder, "{sv}", "Visible", g_variant_new_boolean (bVisible));
+            g_dbus_connection_emit_signal (pFlood->pConnection, NULL, "/org/onboard/Onboard/Keyboard", "org.freedesktop.DBus.Properties", "PropertiesChanged", g_variant_new ("(sa{sv}as)", "org.onboard.Onboard.Keyboard", &cBuilder, NULL), NULL);
+        }
+
+        gint64 nDue = nStart + (gint64) nSent * G_USEC_PER_SEC / RATE;
+        gint64 nNow = g_get_monotonic_time ();
+
+        if (nDue > nNow)
+        {
+            g_usleep (nDue - nNow);
+        }
+    }
+
+    g_dbus_connection_flush_sync (pFlood->pConnection, NULL, NULL);
+    pFlood->nCpuTime = harness_get_cpu_time () - nCpuTime;
+    g_atomic_int_set (&pFlood->nDone, 1);
+    g_main_context_wakeup (NULL);
+
+    return NULL;
+}
+
+// Floods the service with one burst size and checks the emissions, stores the CPU time per signal in ns
+// The process time covers the main loop and the GDBus worker that decodes the signals, the flood thread's own time is left out
+static gboolean stressBurst (Harness *pHarness, guint nBurst, gdouble *pCpuPerSignal)
+{
+    Flood cFlood = {harness_get_mock_connection (pHarness), nBurst, 0, 0};
+    guint64 nSignals = stats_get_count (STATS_ONBOARD_SIGNALS);
+    gint64 nDeadline = g_get_monotonic_time () + (gint64) SIGNALS * G_USEC_PER_SEC / RATE + HARNESS_TIMEOUT * 1000;
+    guint nIterations = 0;
+    harness_reset (pHarness);
+
+    gint64 nCpuTime = harness_get_process_cpu_time ();
+    GThread *pThread = g_thread_new ("flood", onFlood, &cFlood);
+
+    while (!g_atomic_int_get (&cFlood.nDone) || stats_get_count (STATS_ONBOARD_SIGNALS) - nSignals < SIGNALS)
+    {
+        if (g_get_monotonic_time () > nDeadline)
+        {
+            break;
+        }
+
+        g_main_context_iteration (NULL, TRUE);
+        nIterations++;
+    }
+
+    // Drain the coalescing idle and the Changed signal it causes
+    while (g_main_context_iteration (NULL, FALSE))
+    {
+        nIterations++;
+    }
+
+    g_thread_join (pThread);
+    nCpuTime = harness_get_process_cpu_time () - nCpuTime - cFlood.nCpuTime;
+    harness_iterate (pHarness, 100);
+
+    guint64 nReceived = stats_get_count (STATS_ONBOARD_SIGNALS) - nSignals;
+    guint nEmissions = harness_get_action (pHarness, "onboard")->nStateEmissions;
+    *pCpuPerSignal = nReceived ? (gdouble) nCpuTime * 1000 / nReceived : 0;
+
+    g_print ("burst=%-5u signals=%-6" G_GUINT64_FORMAT " iterations=%-6u emissions=%-6u cpu=%-8" G_GINT64_FORMAT " us cpu/signal=%.0f ns peak-rss=%ld KiB\n", nBurst, nReceived, nIterations, nEmissions, nCpuTime, *pCpuPerSignal, harness_get_peak_rss ());
+
+    if (nReceived < SIGNALS)
+    {
+        g_printerr ("Only %" G_GUINT64_FORMAT " of %d signals reached the service\n", nReceived, SIGNALS);
+
+        return FALSE;
+    }
+
+    // Counted on the action group itself, the exporter merges the Changed signals of one iteration whatever the service does
+    // The idle applies the newest value once, so there is never more than one emission per iteration, and dense bursts collapse
+    if (nEmissions > nIterations || (nBurst >= COALESCED_BURST && nEmissions * 10 > nReceived))
+    {
+        g_printerr ("%u state emissions for %" G_GUINT64_FORMAT " signals in %u iterations, the bursts were not collapsed\n", nEmissions, nReceived, nIterations);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+int main (int argc, char **argv)
+{
+    const guint lBursts[] = {1, 10, 100, 1000};
+    gdouble lCpuPerSignal[G_N_ELEMENTS (lBursts)];
+    gboolean bPassed = TRUE;
+
+    Harness *pHarness = harness_new ("GNOME", TRUE);
+
+    // Let the service subscribe to the mock Onboard and read its properties
+    harness_iterate (pHarness, 200);
+    g_print ("Onboard PropertiesChanged flood, %d signals at %d per second\n", SIGNALS, RATE);
+
+    for (guint nBurst = 0; nBurst < G_N_ELEMENTS (lBursts) && bPassed; nBurst++)
+    {
+        bPassed = stressBurst (pHarness, lBursts[nBurst], &lCpuPerSignal[nBurst]);
+    }
+
+    // Denser bursts must not make a single signal more expensive than the evenly spaced ones
+    for (guint nBurst = 1; nBurst < G_N_ELEMENTS (lBursts) && bPassed; nBurst++)
+    {
+        if (lCpuPerSignal[nBurst] > lCpuPerSignal[0] * FLAT_FACTOR)
+        {
+            g_printerr ("CPU per signal grew from %.0f ns at burst %u to %.0f ns at burst %u\n", lCpuPerSignal[0], lBursts[0], lCpuPerSignal[nBurst], lBursts[nBurst]);
+            bPassed = FALSE;
+        }
+    }
+
+    harness_free (pHarness);
+
+    return bPassed ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2023 Robert Tari <robert@tari.in>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "harness.h"
+
+#define ROUNDS 50
+
+// Every path that allocates: switches, sliders, profiles, Onboard signals and settings changed behind our back
+static void runWorkload (Harness *pHarness, const gchar *sBackend)
+{
+    const gchar *lSwitches[] = {"contrast", "onboard", "orca", "sticky-keys", "slow-keys", "bounce-keys", "mouse-keys"};
+    const gchar *lProfiles[] = {"low-vision", "blindness", "dexterity", "default"};
+    const gchar *sKeyboard = g_str_equal (sBackend, "MATE") ? "org.mate.accessibility-keyboard" : "org.gnome.desktop.a11y.keyboard";
+
+    for (guint nRound = 0; nRound < ROUNDS; nRound++)
+    {
+        gboolean bActive = (nRound % 2 == 0);
+
+        for (guint nSwitch = 0; nSwitch < G_N_ELEMENTS (lSwitches); nSwitch++)
+        {
+            harness_set_state (pHarness, lSwitches[nSwitch], g_variant_new_boolean (bActive));
+        }
+
+        harness_set_state (pHarness, "magnifier", g_variant_new_double (1.0 + nRound % 8));
+        harness_set_state (pHarness, "text-scaling", g_variant_new_double (1.0 + (nRound % 4) * 0.25));
+        harness_onboard_set_visible (pHarness, !bActive);
+        harness_set_setting (pHarness, sKeyboard, "slowkeys-enable", g_variant_new_boolean (!bActive));
+        harness_set_setting (pHarness, "org.gnome.desktop.a11y.magnifier", "mag-factor", g_variant_new_double (2.0));
+        harness_iterate (pHarness, 10);
+        harness_activate (pHarness, "profile", g_variant_new_string (lProfiles[nRound % G_N_ELEMENTS (lProfiles)]));
+        harness_iterate (pHarness, 10);
+    }
+}
+
+int main (int argc, char **argv)
+{
+    const gchar *sBackend = argc > 1 ? argv[1] : "GNOME";
+
+    // Start and stop the service twice, so anything left behind by one instance shows up as a leak
+    for (guint nRun = 0; nRun < 2; nRun++)
+    {
+        Harness *pHarness = harness_new (sBackend, TRUE);
+        runWorkload (pHarness, sBackend);
+        harness_free (pHarness);
+    }
+
+    return 0;
+}